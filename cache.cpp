@@ -0,0 +1,164 @@
+/*
+	Module Name: cache.cpp
+	Description: keeps output of runs in a cache directory keyed by hash of input file, rfile 		and options, so that a repeated run prints stored output without simulating.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// hashed into every key, to be bumped whenever a change of sched changes output of a 
+// run so that outputs stored by older builds are not used
+const uint32_t CACHE_VERSION = 1;
+
+char __cache_path[4096]; // cache file of current run
+char __cache_temp[4096]; // temporary file output is written to till run is complete
+int __saved_stdout = -1; // stdout of sched while output goes to temporary file
+
+
+uint64_t hash_bytes(const char *bytes, long length, uint64_t hash) {
+	/*
+		Function Name: hash_bytes
+		Arguments:
+			const char *bytes: data to be hashed
+			long length: number of bytes
+			uint64_t hash: hash of data before bytes
+		Returns: uint64_t - FNV-1a hash of data followed by bytes
+		Description: continues FNV-1a hash over bytes
+	*/
+	for(long i = 0; i < length; i++) {
+		hash ^= (unsigned char)bytes[i];
+		hash *= UINT64_C(0x100000001b3);
+	}
+	return hash;
+}
+
+bool hash_file(char *filename, uint64_t *hash) {
+	/*
+		Function Name: hash_file
+		Arguments:
+			char *filename: file to be hashed
+			uint64_t *hash: hash of data before file, continued over contents of file 			followed by its length
+		Returns: bool - false if file could not be read
+		Description: hashes whole contents of file
+	*/
+	char buffer[65536];
+	long total = 0;
+	int length;
+	int fd = open(filename, O_RDONLY);
+	if(fd < 0) {
+		return false;
+	}
+	while((length = read(fd, buffer, sizeof(buffer))) > 0) {
+		*hash = hash_bytes(buffer, length, *hash);
+		total += length;
+	}
+	close(fd);
+	if(length < 0) {
+		return false;
+	}
+	*hash = hash_bytes((char*)&total, sizeof(total), *hash);
+	return true;
+}
+
+void copy_to_stdout(char *filename) {
+	/*
+		Function Name: copy_to_stdout
+		Arguments:
+			char *filename: file to be printed
+		Returns: void
+		Description: prints contents of file as it is
+	*/
+	char buffer[65536];
+	int length;
+	int fd = open(filename, O_RDONLY);
+	if(fd < 0) {
+		return;
+	}
+	fflush(stdout);
+	while((length = read(fd, buffer, sizeof(buffer))) > 0) {
+		fwrite(buffer, 1, length, stdout);
+	}
+	close(fd);
+}
+
+void cache_abandon() {
+	/*
+		Function Name: cache_abandon
+		Returns: void
+		Description: called at exit, if run exits before cache_store its output is not 		stored, stdout is restored, output so far is printed and temporary file removed
+	*/
+	if(__saved_stdout < 0) {
+		return;
+	}
+	fflush(stdout);
+	dup2(__saved_stdout, 1);
+	close(__saved_stdout);
+	__saved_stdout = -1;
+	copy_to_stdout(__cache_temp);
+	unlink(__cache_temp);
+}
+
+bool cache_lookup(char *dir, char *input_file, char *rfile, char *config) {
+	/*
+		Function Name: cache_lookup
+		Arguments:
+			char *dir: cache directory, created if missing
+			char *input_file: input file of run
+			char *rfile: rfile of run
+			char *config: options of run affecting its output
+		Returns: bool - true if output was found in cache and printed
+		Description: looks up output of run by hash of CACHE_VERSION, both files and 		config. On a miss output is redirected to a temporary file till cache_store is called. If either 		file cannot be read run is not cached at all, so that its output is not kept for 		other missing files.
+	*/
+	uint64_t hash = UINT64_C(0xcbf29ce484222325);
+	hash = hash_bytes((char*)&CACHE_VERSION, sizeof(CACHE_VERSION), hash);
+	if(!hash_file(input_file, &hash) || !hash_file(rfile, &hash)) {
+		return false;
+	}
+	hash = hash_bytes(config, strlen(config), hash);
+
+	mkdir(dir, 0755);
+	snprintf(__cache_path, sizeof(__cache_path), "%s/%016llx", dir, (unsigned long long)hash);
+	if(access(__cache_path, R_OK) == 0) {
+		copy_to_stdout(__cache_path);
+		return true;
+	}
+
+	// temporary file is unique to this process so that concurrent runs do not mix
+	snprintf(__cache_temp, sizeof(__cache_temp), "%s.%d.tmp", __cache_path, (int)getpid());
+	int fd = open(__cache_temp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(fd < 0) {
+		return false;
+	}
+	fflush(stdout);
+	__saved_stdout = dup(1);
+	dup2(fd, 1);
+	close(fd);
+	atexit(cache_abandon);
+	return false;
+}
+
+void cache_store() {
+	/*
+		Function Name: cache_store
+		Returns: void
+		Description: ends redirection started by cache_lookup, renames temporary file to 		its cache file which makes it visible to other runs at once and completely, and 		prints the output
+	*/
+	if(__saved_stdout < 0) {
+		return;
+	}
+	fflush(stdout);
+	dup2(__saved_stdout, 1);
+	close(__saved_stdout);
+	__saved_stdout = -1;
+	if(rename(__cache_temp, __cache_path) == 0) {
+		copy_to_stdout(__cache_path);
+	} else {
+		copy_to_stdout(__cache_temp);
+		unlink(__cache_temp);
+	}
+}
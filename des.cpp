@@ -3,10 +3,60 @@
 	Description: simulates discrete event system, by maintain and simulating a priority 		queue
 */
 #include "scheduler.h"
-#include <list>
 
-// data structure for holding all events
-std::list<Event*> event_queue;
+// data structure for holding all events, intrusive doubly linked list using links
+// embedded in events so that no insertion or removal allocates
+Event *__event_head = NULL;
+Event *__event_tail = NULL;
+
+void link_event(Event *position, Event *event) {
+	/*
+		Function Name: link_event
+		Arguments:
+			Event *position: event in queue before which event is linked, NULL for end
+			Event *event: event to be linked, must not be in queue
+		Returns: void
+		Description: links event into queue before position
+	*/
+	assert(!event->queued);
+	event->queued = true;
+	event->next = position;
+	event->prev = position != NULL ? position->prev : __event_tail;
+	if(event->prev != NULL) {
+		event->prev->next = event;
+	} else {
+		__event_head = event;
+	}
+	if(position != NULL) {
+		position->prev = event;
+	} else {
+		__event_tail = event;
+	}
+}
+
+void unlink_event(Event *event) {
+	/*
+		Function Name: unlink_event
+		Arguments:
+			Event *event: event in queue
+		Returns: void
+		Description: unlinks event from queue
+	*/
+	assert(event->queued);
+	if(event->prev != NULL) {
+		event->prev->next = event->next;
+	} else {
+		__event_head = event->next;
+	}
+	if(event->next != NULL) {
+		event->next->prev = event->prev;
+	} else {
+		__event_tail = event->prev;
+	}
+	event->prev = NULL;
+	event->next = NULL;
+	event->queued = false;
+}
 
 void put_event(Event *event, bool pushback = false) {
 	/*
@@ -20,21 +70,50 @@ void put_event(Event *event, bool pushback = false) {
 
 	// if pushback is true then insert at end
 	if(pushback) {
-		event_queue.push_back(event);
+		link_event(NULL, event);
 		return;
 	}
 
-	// otherwise look for correct location so that timestamps are in sorted order 
+	// otherwise look for correct location so that timestamps are in sorted order
 	// and insert there
-	std::list<Event*>::iterator index;
-	for(index = event_queue.begin(); index != event_queue.end(); index++) {
-		if((*index)->timestamp > event->timestamp) {
+	Event *index;
+	for(index = __event_head; index != NULL; index = index->next) {
+		if(index->timestamp > event->timestamp) {
+			break;
+		}
+	}
+	link_event(index, event);
+}
+
+
+void put_arrival(Event *event) {
+	/*
+		Function Name: put_arrival
+		Arguments:
+			Event *event: create event of a process arriving after simulation has started
+		Returns: void
+		Description: Inserts the event after create events but before other events with 		same timestamp, which is where it would be if it was put before simulation started
+	*/
+	Event *index;
+	for(index = __event_head; index != NULL; index = index->next) {
+		if(index->timestamp > event->timestamp ||
+			(index->timestamp == event->timestamp && index->oldstate != CREATE)) {
 			break;
 		}
 	}
-	event_queue.insert(index, event);
+	link_event(index, event);
 }
 
+void cancel_event(Event *event) {
+	/*
+		Function Name: cancel_event
+		Arguments:
+			Event *event: event previously inserted using put_event
+		Returns: void
+		Description: Cancels the event in constant time by unlinking it from the queue
+	*/
+	unlink_event(event);
+}
 
 Event* get_event() {
 	/*
@@ -44,22 +123,33 @@ Event* get_event() {
 	*/
 
 	// if no events present in the queue then return null
-	if(event_queue.size() == 0) {
+	if(__event_head == NULL) {
 		return NULL;
 	}
 
 	// return first element
-	Event *event = event_queue.front();
-	event_queue.pop_front();
+	Event *event = __event_head;
+	unlink_event(event);
 	return event;
 }
 
-int get_next_event_time() {
+long long get_next_event_time() {
 	/*
 		Function Name: get_next_event_time
-		Returns: int: timestamp of next event
+		Returns: long long: timestamp of next event
 		Description: return timestamp of event in front of queue
 	*/
-	if(event_queue.size() == 0) return -1;
-	return event_queue.front()->timestamp;
-}
\ No newline at end of file
+	if(__event_head == NULL) return -1;
+	return __event_head->timestamp;
+}
+
+void clear_events() {
+	/*
+		Function Name: clear_events
+		Returns: void
+		Description: removes all events from the queue
+	*/
+	while(__event_head != NULL) {
+		unlink_event(__event_head);
+	}
+}
@@ -0,0 +1,202 @@
+/*
+	Module Name: generator.cpp
+	Description: generates synthetic processes from a workload spec, deterministically from 		a seed, so that they can be fed to simulation without any input file.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <math.h>
+
+/************************** Imported from random.cpp **************************/
+extern uint64_t splitmix64(uint64_t *state);
+
+// arrival processes
+enum Arrival {POISSON, BURSTY, PERIODIC};
+
+// distribution of a column, parameters depend on kind
+struct Distribution {
+	char kind; // 'c' constant a, 'u' uniform in [a, b], 'e' exponential with mean a
+	double a;
+	double b;
+};
+
+long long __gen_count; // processes left to generate
+uint64_t __gen_state; // generator state
+Arrival __arrival;
+double __gap; // mean gap between arrivals, period for PERIODIC
+int __burst; // processes arriving together for BURSTY
+int __burst_left; // processes left in current burst
+double __time; // arrival time of last process
+Distribution __dist[3]; // distributions of tc, cb and io
+const char *__dist_names[] = {"tc", "cb", "io"};
+
+
+double uniform01() {
+	/*
+		Function Name: uniform01
+		Returns: double - pseudo random number in [0, 1)
+		Description: takes top 53 bits of next generator output
+	*/
+	return (splitmix64(&__gen_state) >> 11) * (1.0/9007199254740992.0);
+}
+
+double exponential(double mean) {
+	/*
+		Function Name: exponential
+		Arguments:
+			double mean: mean of distribution
+		Returns: double - exponentially distributed pseudo random number
+		Description: inverse transform of uniform01
+	*/
+	return -mean * log(1.0 - uniform01());
+}
+
+bool parse_distribution(char *text, Distribution *dist) {
+	/*
+		Function Name: parse_distribution
+		Arguments:
+			char *text: "const:<v>", "uniform:<lo>:<hi>" or "exp:<mean>", mean must not be 			negative
+			Distribution *dist: set from text
+		Returns: bool - false if text is not a distribution
+		Description: parses distribution of a column
+	*/
+	if(sscanf(text, "const:%lf", &dist->a) == 1) {
+		dist->kind = 'c';
+	} else if(sscanf(text, "uniform:%lf:%lf", &dist->a, &dist->b) == 2 && dist->a <= dist->b) {
+		dist->kind = 'u';
+	} else if(sscanf(text, "exp:%lf", &dist->a) == 1 && dist->a >= 0) {
+		dist->kind = 'e';
+	} else {
+		return false;
+	}
+	return true;
+}
+
+int sample(Distribution *dist) {
+	/*
+		Function Name: sample
+		Arguments:
+			Distribution *dist: distribution to sample
+		Returns: int - sampled value, atleast 1
+		Description: draws a value from the distribution
+	*/
+	double value;
+	if(dist->kind == 'c') {
+		value = dist->a;
+	} else if(dist->kind == 'u') {
+		value = dist->a + floor(uniform01() * (dist->b - dist->a + 1));
+	} else {
+		value = floor(exponential(dist->a) + 0.5);
+	}
+	if(value < 1) {
+		return 1;
+	}
+	return value > INT_MAX/2 ? INT_MAX/2 : (int)value;
+}
+
+bool parse_workload_spec(char *spec) {
+	/*
+		Function Name: parse_workload_spec
+		Arguments:
+			char *spec: comma separated key=value list, keys are
+				n: number of processes, default 1000
+				seed: seed of generator, default 1
+				arrival: "poisson:<mean gap>", "bursty:<mean gap>:<burst size>" or 				"periodic:<period>", gap and period must not be negative, 				default poisson:50
+				tc, cb, io: distribution as for parse_distribution, default uniform:50:1000, 				uniform:1:40 and uniform:1:40
+		Returns: bool - false if spec is invalid
+		Description: sets up generator for the spec
+	*/
+	uint64_t seed = 1;
+	__gen_count = 1000;
+	__arrival = POISSON;
+	__gap = 50;
+	__burst = 1;
+	parse_distribution((char*)"uniform:50:1000", &__dist[0]);
+	parse_distribution((char*)"uniform:1:40", &__dist[1]);
+	parse_distribution((char*)"uniform:1:40", &__dist[2]);
+
+	char *copy = strdup(spec);
+	for(char *item = strtok(copy, ","); item != NULL; item = strtok(NULL, ",")) {
+		char *value = strchr(item, '=');
+		if(value == NULL) {
+			fprintf(stderr, "invalid workload spec item: %s\n", item);
+			free(copy);
+			return false;
+		}
+		*value++ = '\0';
+		bool valid = true;
+		if(strcmp(item, "n") == 0) {
+			char *end;
+			__gen_count = strtoll(value, &end, 10);
+			valid = (end != value && *end == '\0' && __gen_count >= 0);
+		} else if(strcmp(item, "seed") == 0) {
+			seed = strtoull(value, NULL, 10);
+		} else if(strcmp(item, "arrival") == 0) {
+			if(sscanf(value, "poisson:%lf", &__gap) == 1) {
+				__arrival = POISSON;
+			} else if(sscanf(value, "bursty:%lf:%d", &__gap, &__burst) == 2 && __burst > 0) {
+				__arrival = BURSTY;
+			} else if(sscanf(value, "periodic:%lf", &__gap) == 1) {
+				__arrival = PERIODIC;
+			} else {
+				valid = false;
+			}
+			// gap or period below zero would make arrival times go backwards
+			valid = valid && __gap >= 0;
+		} else {
+			valid = false;
+			for(int i = 0; i < 3; i++) {
+				if(strcmp(item, __dist_names[i]) == 0) {
+					valid = parse_distribution(value, &__dist[i]);
+				}
+			}
+		}
+		if(!valid) {
+			fprintf(stderr, "invalid workload spec item: %s=%s\n", item, value);
+			free(copy);
+			return false;
+		}
+	}
+	free(copy);
+
+	__gen_state = seed;
+	__burst_left = 0;
+	__time = 0;
+	return true;
+}
+
+bool generate_arrival(long long *arrival) {
+	/*
+		Function Name: generate_arrival
+		Arguments:
+			long long *arrival: set to at, tc, cb and io of next process
+		Returns: bool - false when all processes are generated
+		Description: generates next process, arrival times are non decreasing. Generation 		also stops once arrival time is past 2^53 where double no longer holds it exactly.
+	*/
+	if(__gen_count <= 0) {
+		return false;
+	}
+	if(__arrival == POISSON) {
+		__time += exponential(__gap);
+	} else if(__arrival == BURSTY) {
+		// a burst arrives together, bursts are poisson with same mean rate
+		if(__burst_left == 0) {
+			__time += exponential(__gap * __burst);
+			__burst_left = __burst;
+		}
+		__burst_left--;
+	} else {
+		__time += __gap;
+	}
+	if(__time > 9007199254740992.0) {
+		return false;
+	}
+	__gen_count--;
+	arrival[0] = (long long)__time;
+	for(int i = 0; i < 3; i++) {
+		arrival[i+1] = sample(&__dist[i]);
+	}
+	return true;
+}
@@ -5,16 +5,95 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include "scheduler.h"
 
 /************************** Imported from random.cpp **************************/
-extern void load_random_numbers(char *filename);
+extern int read_random_numbers(char *filename, int **numbers);
+extern void use_random_numbers(int *numbers, int size);
+extern Streams* generate_streams(std::vector<Process*> &processes, bool seeded, uint64_t seed);
 
 /************************** Imported from process.cpp **************************/
-extern void load_processes(char *filename);
+extern std::vector<Process*> processes;
+extern Workload* read_workload(char *filename);
+extern void build_processes(Workload *workload);
+extern void attach_streams(Streams *streams);
+extern void reset_processes();
+extern void start_streaming(char *filename, int roll_every);
+extern bool quiet;
+extern void write_workload(Workload *workload, char *filename);
+extern void print_percentiles();
+extern void dump_histograms(char *filename);
+extern bool merge_histograms(char *filename);
+
+/************************** Imported from sampler.cpp **************************/
+extern void start_sampling(int interval, int capacity);
+extern void write_samples(char *filename);
+
+/************************** Imported from generator.cpp **************************/
+extern bool parse_workload_spec(char *spec);
 
 /************************** Imported from simulation.cpp **************************/
 extern void simulate(char sched, int num, bool verbose);
 
+/************************** Imported from server.cpp **************************/
+extern void serve(std::vector<char*> &input_files, std::vector<char*> &rfiles, char *socket_path, int workers, bool crn, bool seeded, uint64_t seed);
+
+/************************** Imported from cache.cpp **************************/
+extern bool cache_lookup(char *dir, char *input_file, char *rfile, char *config);
+extern void cache_store();
+
+/************************** Imported from optimizer.cpp **************************/
+extern void optimize(Workload *workload, Streams *streams, int *numbers, int size, char sched, char *objective, int low, int high, int step, int workers);
+
+char* run_file(char *filename, char *spec, bool several) {
+	/*
+		Function Name: run_file
+		Arguments:
+			char *filename: output file given on command line
+			char *spec: value of -s option of the run
+			bool several: whether more than one scheduler is run
+		Returns: char* - filename, or filename with ".<spec>" appended if several runs
+		Description: gives each run its own output file when several schedulers are run
+	*/
+	if(!several) {
+		return filename;
+	}
+	static char name[4096];
+	snprintf(name, sizeof(name), "%s.%s", filename, spec);
+	return name;
+}
+
+void print_paired(char *spec, char *base_spec, std::vector<long long> &tt, std::vector<long long> &base_tt, std::vector<long long> &cw, std::vector<long long> &base_cw) {
+	/*
+		Function Name: print_paired
+		Arguments:
+			char *spec, *base_spec: value of -s option of the run and of the first run
+			std::vector<long long> &tt, &base_tt: turnaround time of processes in both runs
+			std::vector<long long> &cw, &base_cw: cpu wait time of processes in both runs
+		Returns: void
+		Description: prints mean, standard deviation and 95% confidence half width of 		per process difference of turnaround and cpu wait time against first run
+	*/
+	int n = tt.size();
+	printf("PAIRED %s - %s:", spec, base_spec);
+	for(int m = 0; m < 2; m++) {
+		std::vector<long long> &a = m == 0 ? tt : cw;
+		std::vector<long long> &b = m == 0 ? base_tt : base_cw;
+		double sum = 0, sum_sq = 0;
+		for(int i = 0; i < n; i++) {
+			double d = a[i] - b[i];
+			sum += d;
+			sum_sq += d*d;
+		}
+		double mean = sum/n;
+		double sd = n > 1 ? sqrt((sum_sq - n*mean*mean)/(n-1)) : 0.0;
+		printf(" %s mean=%.2lf sd=%.2lf ci95=%.2lf", m == 0 ? "tt" : "cw", mean, sd, 1.96*sd/sqrt((double)n));
+	}
+	printf("\n");
+}
+
 int main(int argc, char *argv[]) {
 	/*
 		Function Name: main
@@ -29,33 +108,255 @@ int main(int argc, char *argv[]) {
 	int num = -1; //required only if -s option is 'R' or 'P'
 	bool verbose = false; //check presend of -v option
 	char sched = 'n'; //just a initialization
+	std::vector<char*> scheds; //values of -s option, every one is run on same inputs
+	bool crn = false; //common random numbers mode, -n or -N option
+	bool seeded = false; //streams from seeded generator instead of rfile, -N option
+	uint64_t seed = 0; //seed given with -N option
+	int roll_every = -1; //finished processes per ROLL line, streaming mode if not -1
+	char *objective = NULL; //objective of quantum search given with -O option
+	int low = 1, high = 100, step = 1; //quanta searched, from -q option
+	char *cache_dir = NULL; //result cache directory given with -K option
+	char *spec = NULL; //synthetic workload spec given with -g option
+	bool server = false; //check presence of -D option
+	int workers = 1; //number of worker processes in server mode
+	char *socket_path = NULL; //unix socket for server mode, stdin/stdout if not given
+	std::vector<char*> rfiles; //rfiles given with -r option in server mode
+	char *convert_file = NULL; //binary workload file to be written with -c option
+	bool percentiles = false; //check presence of -p option
+	char *histogram_file = NULL; //file histograms are dumped to with -H option
+	bool merge = false; //check presence of -m option
+	int interval = 0, capacity = 65536; //sampling interval and samples kept, from -i option
+	char *sample_file = (char*)"samples.csv"; //file samples are written to, from -o option
 
 	//read for options
-	while((opt = getopt(argc, argv, "vs:")) != -1) {
+	while((opt = getopt(argc, argv, "vs:Dw:u:r:c:pH:mi:o:nN:f:O:q:K:g:Q")) != -1) {
 		switch(opt) {
 		case 'v':
 			verbose = true;
 			break;
 		case 's':
-			if(optarg != NULL) sched = optarg[0];
-			if(sched == 'R' || sched == 'P') {
-				num = atoi(optarg+1);
-			}
+			scheds.push_back(optarg);
+			break;
+		case 'D':
+			server = true;
+			break;
+		case 'w':
+			workers = atoi(optarg);
+			break;
+		case 'u':
+			socket_path = optarg;
+			break;
+		case 'r':
+			rfiles.push_back(optarg);
+			break;
+		case 'c':
+			convert_file = optarg;
+			break;
+		case 'p':
+			percentiles = true;
+			break;
+		case 'H':
+			histogram_file = optarg;
+			break;
+		case 'm':
+			merge = true;
+			break;
+		case 'i':
+			sscanf(optarg, "%d,%d", &interval, &capacity);
+			break;
+		case 'o':
+			sample_file = optarg;
+			break;
+		case 'n':
+			crn = true;
+			break;
+		case 'N':
+			crn = true;
+			seeded = true;
+			seed = strtoull(optarg, NULL, 10);
+			break;
+		case 'f':
+			roll_every = atoi(optarg);
+			break;
+		case 'O':
+			objective = optarg;
+			break;
+		case 'q':
+			sscanf(optarg, "%d,%d,%d", &low, &high, &step);
+			break;
+		case 'K':
+			cache_dir = optarg;
+			break;
+		case 'g':
+			spec = optarg;
+			break;
+		case 'Q':
+			quiet = true;
 			break;
 		default:
 			printf("Invalid Option\n");
 		}
 	}
+
+	// convert input file to binary workload file and exit, no rfile needed
+	if(convert_file != NULL) {
+		write_workload(read_workload(argv[optind]), convert_file);
+		return 0;
+	}
+
+	// merge histograms dumped by earlier runs, all remaining arguments are dump files
+	if(merge) {
+		for(int i = optind; i < argc; i++) {
+			if(!merge_histograms(argv[i])) {
+				return 1;
+			}
+		}
+		print_percentiles();
+		if(histogram_file != NULL) {
+			dump_histograms(histogram_file);
+		}
+		return 0;
+	}
+
+	// in server mode all remaining arguments are input files, rfiles come from -r
+	if(server) {
+		std::vector<char*> input_files(argv+optind, argv+argc);
+		serve(input_files, rfiles, socket_path, workers, crn, seeded, seed);
+		return 0;
+	}
 	
+	// synthetic workload is streamed into simulation, only argument left is rfile
+	char *input_file = argv[optind];
+	char *rfile = argv[optind+1];
+	if(spec != NULL) {
+		if(!parse_workload_spec(spec)) {
+			return 1;
+		}
+		if(roll_every == -1) {
+			roll_every = 0;
+		}
+		input_file = NULL;
+		rfile = argv[optind];
+	}
+
+	// quantum search simulates whole workload many times, which streamed input cannot give
+	if(objective != NULL && roll_every != -1) {
+		fprintf(stderr, "-O cannot be used with -f or -g\n");
+		return 1;
+	}
+
+	// runs whose whole output goes to stdout are looked up in result cache, config has 
+	// every option affecting that output
+	bool cached = cache_dir != NULL && histogram_file == NULL && interval == 0 && roll_every == -1 && objective == NULL;
+	if(cached) {
+		char options[128];
+		snprintf(options, sizeof(options), "v=%d p=%d Q=%d n=%d N=%d,%llu s=", verbose, percentiles, quiet, crn, seeded, (unsigned long long)seed);
+		std::string config = options;
+		for(int r = 0; r < scheds.size(); r++) {
+			config += scheds[r];
+			config += ",";
+		}
+		if(cache_lookup(cache_dir, input_file, rfile, (char*)config.c_str())) {
+			return 0;
+		}
+	}
+
 	// optind gives location of other command line arguments other than options. 
 	// optind+1 would have file path for rfile
-	load_random_numbers(argv[optind+1]);
+	int *numbers;
+	int size = read_random_numbers(rfile, &numbers);
 
-	// loads process and passes optind pointing to filepath for input file.
-	load_processes(argv[optind]);
+	if(scheds.size() == 0) {
+		scheds.push_back((char*)"n");
+	}
+
+	// loads workload, optind points to filepath for input file. When streaming input 
+	// can only be read once, so only first scheduler is run.
+	Workload *workload = NULL;
+	if(roll_every == -1) {
+		workload = read_workload(input_file);
+	} else {
+		start_streaming(input_file, roll_every);
+		if(crn) {
+			fprintf(stderr, "warning: -n and -N are ignored when streaming\n");
+		}
+		if(scheds.size() > 1) {
+			fprintf(stderr, "warning: only first -s is run when streaming\n");
+		}
+		crn = false;
+		scheds.resize(1);
+	}
 
-	//start simulation
-	simulate(sched, num, verbose);
+	// search quantum of first scheduler instead of running it
+	if(objective != NULL) {
+		Streams *streams = NULL;
+		if(crn) {
+			use_random_numbers(numbers, size);
+			build_processes(workload);
+			streams = generate_streams(processes, seeded, seed);
+			reset_processes();
+		}
+		optimize(workload, streams, numbers, size, scheds[0][0], objective, low, high, step, workers);
+		return 0;
+	}
+	bool several = scheds.size() > 1;
+	Streams *streams = NULL; // generated once and shared by all runs
+	std::vector<long long> base_tt, base_cw, tt, cw; // per process metrics for paired deltas
+
+	for(int r = 0; r < scheds.size(); r++) {
+		sched = scheds[r][0];
+		num = -1;
+		if(sched == 'R' || sched == 'P' || sched == 'E') {
+			num = atoi(scheds[r]+1);
+		}
+
+		// every run starts from same state of random numbers and processes
+		use_random_numbers(numbers, size);
+		reset_processes();
+		if(workload != NULL) {
+			build_processes(workload);
+		}
+		if(crn) {
+			if(streams == NULL) {
+				streams = generate_streams(processes, seeded, seed);
+			}
+			attach_streams(streams);
+		}
+
+		//start simulation
+		if(interval > 0) {
+			start_sampling(interval, capacity);
+		}
+		simulate(sched, num, verbose);
+		if(interval > 0) {
+			write_samples(run_file(sample_file, scheds[r], several));
+		}
+		if(percentiles) {
+			print_percentiles();
+		}
+		if(histogram_file != NULL) {
+			dump_histograms(run_file(histogram_file, scheds[r], several));
+		}
+
+		// pair each process with itself in first run
+		if(several) {
+			tt.clear();
+			cw.clear();
+			for(int i = 0; i < processes.size(); i++) {
+				tt.push_back(processes[i]->tt);
+				cw.push_back(processes[i]->cw);
+			}
+			if(r == 0) {
+				base_tt = tt;
+				base_cw = cw;
+			} else {
+				print_paired(scheds[r], scheds[0], tt, base_tt, cw, base_cw);
+			}
+		}
+	}
+	if(cached) {
+		cache_store();
+	}
 	
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,277 @@
+/*
+	Module Name: optimizer.cpp
+	Description: searches quantum of RR, PRIO or PREPRIO scheduler which is best for an 		objective, candidates are simulated in parallel worker processes and runs which cannot 		beat the best one found so far are abandoned early.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+#include "scheduler.h"
+
+/************************** Imported from random.cpp **************************/
+extern void use_random_numbers(int *numbers, int size);
+
+/************************** Imported from process.cpp **************************/
+extern std::vector<Process*> processes;
+extern void build_processes(Workload *workload);
+extern void attach_streams(Streams *streams);
+extern void reset_processes();
+extern Histogram cw_histogram;
+extern long long __finished, __sum_tt, __sum_tc, __sum_at;
+extern long long get_total_time();
+extern double get_cpu_utilization();
+extern double get_avg_turnaround_time();
+extern double get_throughput();
+
+/************************** Imported from simulation.cpp **************************/
+extern void simulate(char sched, int num, bool verbose);
+extern bool (*abort_check)(long long current_time);
+extern bool aborted;
+
+// objectives, all are turned into a key to be minimised
+enum Objective {MIN_TURNAROUND, MIN_P99_WAIT, MAX_THROUGHPUT};
+
+// outcome of simulating one quantum, sent from worker through a pipe
+struct Evaluation {
+	int quantum;
+	bool pruned; // abandoned as it could not beat best key
+	bool feasible; // meets utilization floor of MAX_THROUGHPUT
+	double key; // value minimised
+	double avg_tt;
+	long long p99_cw;
+	double throughput;
+	double utilization;
+};
+
+Objective __objective;
+double __floor; // utilization floor in percent for MAX_THROUGHPUT
+double __bound; // key of best evaluation when worker was started
+int __count; // number of processes
+std::vector<int> __sorted_at; // arrival times in ascending order
+std::vector<long long> __prefix_at; // __prefix_at[i] is sum of first i of __sorted_at
+int __arrived; // processes with arrival time not after current time
+int __events; // events seen by check_bound, bound is checked every 64 events
+
+
+bool check_bound(long long current_time) {
+	/*
+		Function Name: check_bound
+		Arguments:
+			long long current_time: time of event about to be simulated
+		Returns: bool - true if run cannot beat __bound any more
+		Description: computes a lower bound of key from partial run. For turnaround, 		finished processes add their turnaround time and arrived ones add at least time 		since arrival. For p99 wait, finished processes with wait above bound are counted as 		wait only grows. For throughput, total time is at least current time.
+	*/
+	if((++__events & 63) != 0 || __bound >= 1e300) {
+		return false;
+	}
+	if(__objective == MIN_TURNAROUND) {
+		while(__arrived < __count && __sorted_at[__arrived] <= current_time) {
+			__arrived++;
+		}
+		long long unfinished = __arrived - __finished;
+		long long unfinished_at = __prefix_at[__arrived] - __sum_at;
+		double lower = (double)(__sum_tt + unfinished*current_time - unfinished_at) / __count;
+		return lower > __bound;
+	}
+	if(__objective == MIN_P99_WAIT) {
+		// p99 is in bucket holding value of rank ceil(0.99*n), it is above bound once
+		// more than n-rank values are in buckets above bound
+		long long rank = (long long)(0.99*__count + 0.999999);
+		long long above = 0;
+		for(int i = Histogram::bucket_index((long long)__bound) + 1; i < Histogram::BUCKETS; i++) {
+			above += cw_histogram.counts[i];
+		}
+		return above > __count - rank;
+	}
+	return current_time > __bound;
+}
+
+Evaluation evaluate(Workload *workload, Streams *streams, int *numbers, int size, char sched, int quantum) {
+	/*
+		Function Name: evaluate
+		Arguments:
+			Workload *workload: workload to simulate
+			Streams *streams: common random numbers streams, NULL if mode is off
+			int *numbers, int size: random numbers of rfile
+			char sched: scheduler
+			int quantum: quantum to evaluate
+		Returns: Evaluation - metrics of the run
+		Description: simulates with output thrown away, abandoning the run once 		check_bound says it cannot beat __bound
+	*/
+	Evaluation evaluation;
+	memset(&evaluation, 0, sizeof(evaluation));
+	evaluation.quantum = quantum;
+
+	use_random_numbers(numbers, size);
+	reset_processes();
+	build_processes(workload);
+	if(streams != NULL) {
+		attach_streams(streams);
+	}
+	__arrived = 0;
+	__events = 0;
+	abort_check = check_bound;
+
+	int null_fd = open("/dev/null", O_WRONLY);
+	dup2(null_fd, 1);
+	close(null_fd);
+	simulate(sched, quantum, false);
+	fflush(stdout);
+
+	if(aborted) {
+		evaluation.pruned = true;
+		return evaluation;
+	}
+	evaluation.avg_tt = get_avg_turnaround_time();
+	evaluation.p99_cw = cw_histogram.percentile(99);
+	evaluation.throughput = get_throughput();
+	evaluation.utilization = get_cpu_utilization();
+	evaluation.feasible = true;
+	if(__objective == MIN_TURNAROUND) {
+		evaluation.key = evaluation.avg_tt;
+	} else if(__objective == MIN_P99_WAIT) {
+		evaluation.key = evaluation.p99_cw;
+	} else {
+		evaluation.key = get_total_time();
+		evaluation.feasible = evaluation.utilization >= __floor;
+	}
+	return evaluation;
+}
+
+void optimize(Workload *workload, Streams *streams, int *numbers, int size, char sched, char *objective, int low, int high, int step, int workers) {
+	/*
+		Function Name: optimize
+		Arguments:
+			Workload *workload: workload to simulate
+			Streams *streams: common random numbers streams, NULL if mode is off
+			int *numbers, int size: random numbers of rfile
+			char sched: 'R', 'P' or 'E'
+			char *objective: "tt" for minimum average turnaround, "p99" for minimum p99 		cpu wait or "tp<floor>" for maximum throughput with cpu utilization of atleast 		<floor> percent
+			int low, int high, int step: quanta low, low+step, ... upto high are evaluated
+			int workers: maximum number of quanta simulated at once
+		Returns: void
+		Description: evaluates the quanta in parallel worker processes, each worker is given 		key of best evaluation finished before it started as bound for abandoning its 		run. Prints one line for every quantum and the best one.
+	*/
+	// other schedulers have no quantum, and quantum below 1 never finishes
+	if(sched != 'R' && sched != 'P' && sched != 'E') {
+		printf("Invalid Scheduler\n");
+		return;
+	}
+	if(low < 1 || high < low) {
+		printf("Invalid Quantum Range\n");
+		return;
+	}
+	if(strcmp(objective, "tt") == 0) {
+		__objective = MIN_TURNAROUND;
+	} else if(strcmp(objective, "p99") == 0) {
+		__objective = MIN_P99_WAIT;
+	} else if(strncmp(objective, "tp", 2) == 0) {
+		__objective = MAX_THROUGHPUT;
+		__floor = atof(objective+2);
+	} else {
+		printf("Invalid Objective\n");
+		return;
+	}
+	if(step < 1) {
+		step = 1;
+	}
+	if(workers < 1) {
+		workers = 1;
+	}
+
+	// arrival times sorted once for turnaround bound, shared by all workers
+	__count = workload->count;
+	__sorted_at.assign(workload->at, workload->at + workload->count);
+	std::sort(__sorted_at.begin(), __sorted_at.end());
+	__prefix_at.assign(1, 0);
+	for(int i = 0; i < __count; i++) {
+		__prefix_at.push_back(__prefix_at[i] + __sorted_at[i]);
+	}
+
+	// throughput run cannot meet utilization floor once total time is past this
+	double limit = 1e300;
+	if(__objective == MAX_THROUGHPUT && __floor > 0) {
+		long long tot_tc = 0;
+		for(int i = 0; i < __count; i++) {
+			tot_tc += workload->tc[i];
+		}
+		limit = tot_tc*100.0/__floor;
+	}
+
+	std::map<pid_t, int> running; // worker to read end of its pipe
+	std::vector<Evaluation> evaluations;
+	Evaluation best;
+	bool have_best = false;
+	int next = low;
+
+	while(next <= high || running.size() != 0) {
+		// start workers for remaining quanta while allowed
+		while(next <= high && (int)running.size() < workers) {
+			int pipefd[2];
+			pipe(pipefd);
+			__bound = have_best && best.key < limit ? best.key : limit;
+			fflush(stdout);
+			pid_t pid = fork();
+			if(pid == 0) {
+				close(pipefd[0]);
+				Evaluation evaluation = evaluate(workload, streams, numbers, size, sched, next);
+				write(pipefd[1], &evaluation, sizeof(evaluation));
+				_exit(0);
+			}
+			close(pipefd[1]);
+			running[pid] = pipefd[0];
+			next += step;
+		}
+
+		// collect whichever worker finishes first
+		pid_t pid = waitpid(-1, NULL, 0);
+		if(running.count(pid) == 0) {
+			continue;
+		}
+		Evaluation evaluation;
+		if(read(running[pid], &evaluation, sizeof(evaluation)) != sizeof(evaluation)) {
+			evaluation.pruned = true;
+			evaluation.quantum = -1;
+		}
+		close(running[pid]);
+		running.erase(pid);
+		if(evaluation.quantum < 0) {
+			continue;
+		}
+		evaluations.push_back(evaluation);
+		if(!evaluation.pruned && evaluation.feasible && (!have_best || evaluation.key < best.key ||
+			(evaluation.key == best.key && evaluation.quantum < best.quantum))) {
+			best = evaluation;
+			have_best = true;
+		}
+	}
+
+	/*********************** Print Output *********************/
+	printf("OPT %c %s\n", sched, objective);
+	for(int q = low; q <= high; q += step) {
+		for(int i = 0; i < evaluations.size(); i++) {
+			Evaluation *e = &evaluations[i];
+			if(e->quantum != q) {
+				continue;
+			}
+			if(e->pruned) {
+				printf("%d: pruned\n", q);
+			} else {
+				printf("%d: %s avg_tt=%.2lf p99_cw=%lld throughput=%.3lf util=%.2lf\n", q,
+					e->feasible ? "ok" : "infeasible", e->avg_tt, e->p99_cw, e->throughput, e->utilization);
+			}
+		}
+	}
+	if(have_best) {
+		printf("BEST: %d avg_tt=%.2lf p99_cw=%lld throughput=%.3lf util=%.2lf\n", best.quantum,
+			best.avg_tt, best.p99_cw, best.throughput, best.utilization);
+	} else {
+		printf("BEST: none\n");
+	}
+}
@@ -2,77 +2,280 @@
 	Module Name: process.cpp
 	Description: Loads and maintains data structure to hold processes and gives process 		metrics.
 */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <poll.h>
+#include <new>
 #include <vector>
 #include <fstream>
 #include "scheduler.h"
 
 
 std::vector<Process*> processes; //data structure that holds all processes.
+Process *__process_table = NULL; // one block holding all processes built from a workload
+
+// header of binary workload file, followed by at, tc, cb and io columns of count 32 bit 
+// integers each
+struct WorkloadHeader {
+	char magic[4]; // "DESW"
+	uint32_t version;
+	uint64_t count;
+	uint64_t checksum; // see update_checksum
+};
+
+const uint32_t WORKLOAD_VERSION = 1;
+
+// histograms of turnaround time, cpu wait time and io time of finished processes
+Histogram tt_histogram, cw_histogram, it_histogram;
+const char *histogram_names[] = {"TT", "CW", "IT"};
+Histogram *histograms[] = {&tt_histogram, &cw_histogram, &it_histogram};
+
+// totals over finished processes, metrics of SUM line are computed from them
+long long __finished, __sum_tt, __sum_cw, __sum_tc, __sum_at;
+long long __max_ft;
+
+// streaming mode, processes are read as they arrive and deleted once finished
+bool streaming = false;
+bool quiet = false; // finished processes are not printed
+bool __generating; // processes come from generator instead of input
+int __stream_fd; // input being read
+char __stream_buffer[65536]; // bytes read from input but not yet parsed
+int __stream_pos, __stream_len;
+bool __have_next; // whether next arrival has been read
+long long __next[4]; // at, tc, cb, io of next arrival
+int __next_pid; // pid of next arrival
+int __roll_every; // finished processes per ROLL line, 0 for none
+long long __roll_finished, __roll_tt, __roll_cw; // totals since last ROLL line
+long long __roll_time; // time of last ROLL line
 
 /************************** Imported from random.cpp **************************/
 extern int myrandom(int burst);
 
+/************************** Imported from generator.cpp **************************/
+extern bool generate_arrival(long long *arrival);
+
 /************************** Imported from des.cpp **************************/
 extern void put_event(Event *event, bool pushback);
+extern void put_arrival(Event *event);
+extern void clear_events();
 
 
 
-void load_processes(char *filename) {
+void update_checksum(int *values, long length, uint64_t *sum1, uint64_t *sum2) {
 	/*
-		Function Name: load_processes
+		Function Name: update_checksum
 		Arguments:
-			char *filename: path to input file
+			int *values: integers to be added to checksum
+			long length: number of integers in values
+			uint64_t *sum1, *sum2: running sums of checksum, both start at zero
 		Returns: void
-		Description: loads processes from file and initializes process data structure 			with processes
+		Description: adds values to fletcher style checksum stored in header of binary 		workload file, checksum is (sum2 << 32) ^ sum1 after all columns are added
+	*/
+	for(long i = 0; i < length; i++) {
+		*sum1 += (uint32_t)values[i];
+		*sum2 += *sum1;
+	}
+}
+
+Workload* map_workload(char *filename) {
+	/*
+		Function Name: map_workload
+		Arguments:
+			char *filename: path to binary workload file
+		Returns: Workload* - workload whose columns point into the mapped file
+		Description: maps binary workload file into memory and verifies its header and 		checksum, columns are used in place without copying or parsing
+	*/
+	int fd = open(filename, O_RDONLY);
+	struct stat st;
+	if(fd < 0 || fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(WorkloadHeader)) {
+		fprintf(stderr, "%s: cannot read binary workload\n", filename);
+		exit(1);
+	}
+	void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(data == MAP_FAILED) {
+		fprintf(stderr, "%s: cannot map binary workload\n", filename);
+		exit(1);
+	}
+
+	WorkloadHeader *header = (WorkloadHeader*)data;
+	int *columns = (int*)(header + 1);
+	if(header->version != WORKLOAD_VERSION || header->count > 0x7fffffff ||
+		st.st_size != (off_t)(sizeof(WorkloadHeader) + 4*header->count*sizeof(int))) {
+		fprintf(stderr, "%s: invalid binary workload header\n", filename);
+		exit(1);
+	}
+	uint64_t sum1 = 0, sum2 = 0;
+	update_checksum(columns, 4*header->count, &sum1, &sum2);
+	if(((sum2 << 32) ^ sum1) != header->checksum) {
+		fprintf(stderr, "%s: binary workload checksum mismatch\n", filename);
+		exit(1);
+	}
+	return new Workload(header->count, columns);
+}
+
+void write_workload(Workload *workload, char *filename) {
+	/*
+		Function Name: write_workload
+		Arguments:
+			Workload *workload: workload to be written
+			char *filename: path to binary workload file to be created
+		Returns: void
+		Description: writes workload in binary format which is loaded by map_workload
+	*/
+	WorkloadHeader header;
+	uint64_t sum1 = 0, sum2 = 0;
+	int *column[4] = {workload->at, workload->tc, workload->cb, workload->io};
+
+	for(int c = 0; c < 4; c++) {
+		update_checksum(column[c], workload->count, &sum1, &sum2);
+	}
+	memcpy(header.magic, "DESW", 4);
+	header.version = WORKLOAD_VERSION;
+	header.count = workload->count;
+	header.checksum = (sum2 << 32) ^ sum1;
+
+	FILE *file = fopen(filename, "wb");
+	if(file == NULL) {
+		perror(filename);
+		exit(1);
+	}
+	fwrite(&header, sizeof(header), 1, file);
+	for(int c = 0; c < 4; c++) {
+		fwrite(column[c], sizeof(int), workload->count, file);
+	}
+	fclose(file);
+}
+
+Workload* read_workload(char *filename) {
+	/*
+		Function Name: read_workload
+		Arguments:
+			char *filename: path to input file
+		Returns: Workload* - columns read from input file
+		Description: reads input file into a workload without creating any process, so 		that it can be kept and used for building process table any number of times. 		Binary workload files are mapped instead of being read.
 	*/
 
+	// binary workload file is recognised by its magic
+	char magic[4] = {0};
+	FILE *probe = fopen(filename, "rb");
+	if(probe != NULL) {
+		fread(magic, 1, 4, probe);
+		fclose(probe);
+	}
+	if(memcmp(magic, "DESW", 4) == 0) {
+		return map_workload(filename);
+	}
+
 	//mode std::ios_base::in used for reading integers
 	std::fstream file(filename, std::ios_base::in);
 
+	std::vector<int> at, tc, cb, io;
+	int value;
+	while(file >> value) {
+		at.push_back(value);
+		file >> value;
+		tc.push_back(value);
+		file >> value;
+		cb.push_back(value);
+		file >> value;
+		io.push_back(value);
+	}
+
+	Workload *workload = new Workload(at.size());
+	for(int i = 0; i < workload->count; i++) {
+		workload->at[i] = at[i];
+		workload->tc[i] = tc[i];
+		workload->cb[i] = cb[i];
+		workload->io[i] = io[i];
+	}
+	return workload;
+}
+
+void build_processes(Workload *workload) {
+	/*
+		Function Name: build_processes
+		Arguments:
+			Workload *workload: workload to build processes from
+		Returns: void
+		Description: initializes process data structure with processes of workload and 		generates their create events. Processes are constructed in one block allocated 		once instead of one allocation each.
+	*/
 	Process *process;
+	__process_table = (Process*)::operator new((size_t)workload->count * sizeof(Process));
+	processes.reserve(processes.size() + workload->count);
 
-	//pid initialized with zero and incremented with each process.
-	int at, tc, cb, io, pid = 0;
-	while(file >> at) {
-		file >> tc;
-		file >> cb;
-		file >> io;
-		process = new Process(at, tc, cb, io, pid++, myrandom(4)+1);
+	//pid is index of process in workload.
+	for(int pid = 0; pid < workload->count; pid++) {
+		process = new (&__process_table[pid]) Process(workload->at[pid], workload->tc[pid], workload->cb[pid], workload->io[pid], pid, myrandom(4)+1);
 		processes.push_back(process);
 		//generate event for create to ready
-		Event *event = new Event(at, process, CREATE, READY);
-		put_event(event, true);
+		put_event(process->next_event(process->at, CREATE, READY), true);
 	}
 }
 
-bool check_blocked() {
+void attach_streams(Streams *streams) {
 	/*
-		Function Name: check_blocked
-		Returns: bool - true if anyone process is in blocked state, false otherwise.
-		Description: check if anyone process is in blocked state
+		Function Name: attach_streams
+		Arguments:
+			Streams *streams: streams generated for the same workload
+		Returns: void
+		Description: makes processes take their bursts from streams from start
 	*/
-	for(std::vector<Process*>::iterator i = processes.begin(); i != processes.end(); i++) {
-		if((*i)->st == BLOCK) return true;
+	for(int i = 0; i < processes.size(); i++) {
+		int *stream = streams->pool.data() + streams->offset[i];
+		processes[i]->cpu_stream = stream;
+		processes[i]->io_stream = stream + streams->bursts[i];
 	}
-	return false;
 }
 
+void reset_processes() {
+	/*
+		Function Name: reset_processes
+		Returns: void
+		Description: deletes all processes, their pending events and clears histograms 		so that another simulation can be run
+	*/
+	clear_events();
+	if(__process_table != NULL) {
+		// processes were built by build_processes into one block
+		::operator delete(__process_table);
+		__process_table = NULL;
+	} else {
+		for(int i = 0; i < processes.size(); i++) {
+			delete processes[i];
+		}
+	}
+	processes.clear();
+	tt_histogram = Histogram();
+	cw_histogram = Histogram();
+	it_histogram = Histogram();
+	__finished = __sum_tt = __sum_cw = __sum_tc = __sum_at = 0;
+	__max_ft = 0;
+}
+
+void load_processes(char *filename) {
+	/*
+		Function Name: load_processes
+		Arguments:
+			char *filename: path to input file
+		Returns: void
+		Description: loads processes from file and initializes process data structure 			with processes
+	*/
+	build_processes(read_workload(filename));
+}
 
-int get_total_time() {
+long long get_total_time() {
 	/*
 		Function Name: get_total_time
-		Returns: int - finish time of last executing process.
+		Returns: long long - finish time of last executing process.
 		Description: get the end time of simulation.
 	*/
-	int finish_time = 0;
-
-	//basically checks for maximum finish time and returns the same.
-	for(std::vector<Process*>::iterator i = processes.begin(); i != processes.end(); i++) {
-		if(finish_time < (*i)->ft) {
-			finish_time = (*i)->ft;
-		}
-	}
-	return finish_time;
+	return __max_ft;
 }
 
 double get_cpu_utilization() {
@@ -81,12 +284,9 @@ double get_cpu_utilization() {
 		Returns: double - percent of time atleast one process is running
 		Description: basically returns percent of time used in computation
 	*/
-	double tot_time = 0;
 
 	//it sums all total_cpu_time of processes and divides it by simulation time to get the ratio of time used in computation and multiplies the same by 100 to get percentage
-	for(std::vector<Process*>::iterator i = processes.begin(); i != processes.end(); i++) {
-		tot_time += (*i)->tc;
-	}
+	double tot_time = (double)__sum_tc;
 	double fin_time = (double) get_total_time();
 	return (tot_time/fin_time)*100.00;
 }
@@ -98,13 +298,7 @@ double get_avg_turnaround_time() {
 		Returns: double - average turnaround time amongst process
 		Description: computes average of turnaround time for all processes
 	*/
-	double tot_tt = 0;
-
-	//compute average and return the same.
-	for(std::vector<Process*>::iterator i = processes.begin(); i != processes.end(); i++) {
-		tot_tt += (*i)->tt;
-	}
-	return (tot_tt/((double)processes.size()));
+	return (((double)__sum_tt)/((double)__finished));
 }
 
 double get_avg_cpu_wait_time() {
@@ -113,13 +307,7 @@ double get_avg_cpu_wait_time() {
 		Returns: double - average cpu wait time amongst process
 		Description: computes average cpu wait time amongst all processes
 	*/
-	double tot_cw = 0;
-
-	//compute average and return the same.
-	for(std::vector<Process*>::iterator i = processes.begin(); i != processes.end(); i++) {
-		tot_cw += (*i)->cw;
-	}
-	return (tot_cw/((double)processes.size()));
+	return (((double)__sum_cw)/((double)__finished));
 }
 
 double get_throughput() {
@@ -129,5 +317,228 @@ double get_throughput() {
 		Description: computes and returns throughput i.e. number of processes completed 		per 100 time unit
 	*/
 	double fin_time = get_total_time()/100.00; //get total number of 100 time units
-	return (((double)processes.size())/fin_time); //return the ratio
+	return (((double)__finished)/fin_time); //return the ratio
+}
+
+void record_finished(Process *proc) {
+	/*
+		Function Name: record_finished
+		Arguments:
+			Process *proc: process which just finished
+		Returns: void
+		Description: records metrics of the process in histograms and totals
+	*/
+	__finished++;
+	__sum_tt += proc->tt;
+	__sum_cw += proc->cw;
+	__sum_tc += proc->tc;
+	__sum_at += proc->at;
+	if(__max_ft < proc->ft) {
+		__max_ft = proc->ft;
+	}
+	tt_histogram.record(proc->tt);
+	cw_histogram.record(proc->cw);
+	it_histogram.record(proc->it);
+}
+
+void print_percentiles() {
+	/*
+		Function Name: print_percentiles
+		Returns: void
+		Description: prints p50, p90, p99, p99.9 and max of turnaround time, cpu wait 		time and io time, one line for each
+	*/
+	for(int i = 0; i < 3; i++) {
+		printf("%s: p50=%lld p90=%lld p99=%lld p99.9=%lld max=%lld\n",
+			histogram_names[i],
+			histograms[i]->percentile(50),
+			histograms[i]->percentile(90),
+			histograms[i]->percentile(99),
+			histograms[i]->percentile(99.9),
+			histograms[i]->max);
+	}
+}
+
+void dump_histograms(char *filename) {
+	/*
+		Function Name: dump_histograms
+		Arguments:
+			char *filename: path of file to be written
+		Returns: void
+		Description: writes histograms as text, for each histogram a line 		"HIST <name> <total> <max>" followed by "<bucket> <count>" lines for non empty 		buckets and a line "END"
+	*/
+	FILE *file = fopen(filename, "w");
+	if(file == NULL) {
+		perror(filename);
+		return;
+	}
+	for(int i = 0; i < 3; i++) {
+		fprintf(file, "HIST %s %lld %lld\n", histogram_names[i], histograms[i]->total, histograms[i]->max);
+		for(int b = 0; b < Histogram::BUCKETS; b++) {
+			if(histograms[i]->counts[b] != 0) {
+				fprintf(file, "%d %lld\n", b, histograms[i]->counts[b]);
+			}
+		}
+		fprintf(file, "END\n");
+	}
+	fclose(file);
+}
+
+bool merge_histograms(char *filename) {
+	/*
+		Function Name: merge_histograms
+		Arguments:
+			char *filename: path of file written by dump_histograms
+		Returns: bool - false if file could not be read
+		Description: adds histograms of the file to current histograms
+	*/
+	FILE *file = fopen(filename, "r");
+	if(file == NULL) {
+		perror(filename);
+		return false;
+	}
+	char name[8];
+	long long total, count, max;
+	int bucket;
+	while(fscanf(file, " HIST %7s %lld %lld", name, &total, &max) == 3) {
+		Histogram histogram;
+		while(fscanf(file, "%d %lld", &bucket, &count) == 2) {
+			if(bucket >= 0 && bucket < Histogram::BUCKETS) {
+				histogram.counts[bucket] += count;
+			}
+		}
+		fscanf(file, " END");
+		histogram.total = total;
+		histogram.max = max;
+		for(int i = 0; i < 3; i++) {
+			if(strcmp(name, histogram_names[i]) == 0) {
+				histograms[i]->merge(&histogram);
+			}
+		}
+	}
+	fclose(file);
+	return true;
+}
+
+void start_streaming(char *filename, int roll_every) {
+	/*
+		Function Name: start_streaming
+		Arguments:
+			char *filename: input file, pipe or fifo, "-" for stdin, NULL to take processes 			from generator set up by parse_workload_spec
+			int roll_every: finished processes per ROLL line, 0 for none
+		Returns: void
+		Description: makes simulation read processes from filename as they are needed 		instead of loading them before it starts
+	*/
+	__generating = (filename == NULL);
+	__stream_fd = -1;
+	if(!__generating) {
+		__stream_fd = strcmp(filename, "-") == 0 ? 0 : open(filename, O_RDONLY);
+		if(__stream_fd < 0) {
+			perror(filename);
+			exit(1);
+		}
+	}
+	__stream_pos = __stream_len = 0;
+	__have_next = false;
+	__next_pid = 0;
+	__roll_every = roll_every;
+	__roll_finished = __roll_tt = __roll_cw = 0;
+	__roll_time = 0;
+	streaming = true;
+}
+
+int stream_byte() {
+	/*
+		Function Name: stream_byte
+		Returns: int - next byte of input, -1 at end of input
+		Description: reads input in blocks, output is flushed before waiting for input so 		that results of everything simulated so far are out
+	*/
+	if(__stream_pos == __stream_len) {
+		struct pollfd fds;
+		fds.fd = __stream_fd;
+		fds.events = POLLIN;
+		if(poll(&fds, 1, 0) == 0) {
+			fflush(stdout);
+		}
+		__stream_len = read(__stream_fd, __stream_buffer, sizeof(__stream_buffer));
+		__stream_pos = 0;
+		if(__stream_len <= 0) {
+			__stream_len = 0;
+			return -1;
+		}
+	}
+	return (unsigned char)__stream_buffer[__stream_pos++];
+}
+
+bool read_next_arrival() {
+	/*
+		Function Name: read_next_arrival
+		Returns: bool - false at end of input
+		Description: reads at, tc, cb and io of next arrival into __next if not read yet
+	*/
+	if(__generating && !__have_next) {
+		__have_next = generate_arrival(__next);
+		return __have_next;
+	}
+	for(int i = 0; !__have_next && i < 4; i++) {
+		int c = stream_byte();
+		while(c != -1 && (c < '0' || c > '9')) {
+			c = stream_byte();
+		}
+		if(c == -1) {
+			return false;
+		}
+		__next[i] = 0;
+		while(c >= '0' && c <= '9') {
+			__next[i] = __next[i]*10 + (c - '0');
+			c = stream_byte();
+		}
+		__have_next = (i == 3);
+	}
+	return __have_next;
+}
+
+void stream_arrivals(long long time) {
+	/*
+		Function Name: stream_arrivals
+		Arguments:
+			long long time: time of next event, -1 if there is none
+		Returns: void
+		Description: creates processes arriving at or before time and puts their create 		events, if there is no event it waits for next arrival. Input is read only as far 		as simulation has reached, so a writer faster than simulation is held back by 		the pipe and only one arrival is kept in memory ahead of simulation.
+	*/
+	if(time == -1 && read_next_arrival()) {
+		time = __next[0];
+	}
+	while(read_next_arrival() && __next[0] <= time) {
+		Process *process = new Process(__next[0], __next[1], __next[2], __next[3], __next_pid++, myrandom(4)+1);
+		put_arrival(process->next_event(process->at, CREATE, READY));
+		__have_next = false;
+	}
+}
+
+void finish_streamed(Process *proc) {
+	/*
+		Function Name: finish_streamed
+		Arguments:
+			Process *proc: process which just finished, already recorded
+		Returns: void
+		Description: prints the process, prints a ROLL line every __roll_every finished 		processes and deletes the process
+	*/
+	if(!quiet) {
+		proc->print_process();
+	}
+	__roll_finished++;
+	__roll_tt += proc->tt;
+	__roll_cw += proc->cw;
+	if(__roll_every > 0 && __roll_finished == __roll_every) {
+		// averages are over processes finished since last ROLL line
+		long long time = proc->ft;
+		printf("ROLL: %lld %lld %.2lf %.2lf %.3lf\n", time, __finished,
+			((double)__roll_tt)/__roll_finished,
+			((double)__roll_cw)/__roll_finished,
+			time > __roll_time ? __roll_finished*100.0/(time - __roll_time) : 0.0);
+		fflush(stdout);
+		__roll_finished = __roll_tt = __roll_cw = 0;
+		__roll_time = time;
+	}
+	delete proc;
 }
\ No newline at end of file
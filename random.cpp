@@ -3,39 +3,116 @@
 	Description: designed to load random numbers from rfile and generate random numbers as 		per burst provided.
 */
 #include <fstream>
+#include <string.h>
+#include <vector>
+#include "scheduler.h"
 
 
 int *__numbers; //array that holds the numbers
 int __size; //number of random numbers in rfile
-int __curr; //current position in array
+int *__window; //next number to be used, numbers are used from a window of array
+int __window_left; //numbers left in window
 
 
-void load_random_numbers(char *filename) {
+int read_random_numbers(char *filename, int **numbers) {
 	/*
-		Function Name: load_random_numbers
+		Function Name: read_random_numbers
 		Arguments:
 			char *filename: path to rfile
-		Returns: void
-		Description: loads random numbers from rfile into __numbers array and initializes 		__size and __curr
+			int **numbers: set to newly allocated array holding the numbers
+		Returns: int - number of random numbers in rfile
+		Description: reads random numbers from rfile into a new array without making it 		the current source of random numbers
 	*/
-	int num;
+	int num, size, count = 0;
 
 	//open file in std::ios_base::in mode to read integers from file.
 	std::fstream file(filename, std::ios_base::in); 
 
-	//first number read into __size
-	file >> __size; 
-
+	//first number read into size
+	file >> size; 
 
-	__numbers = new int[__size];
-	__curr = 0;
-	while(file >> num) {
-		__numbers[__curr++] = num;
+	*numbers = new int[size];
+	while(count < size && file >> num) {
+		(*numbers)[count++] = num;
 	}
-	__curr = 0;
+	return size;
+}
+
+void use_random_numbers(int *numbers, int size) {
+	/*
+		Function Name: use_random_numbers
+		Arguments:
+			int *numbers: array of random numbers
+			int size: number of random numbers in array
+		Returns: void
+		Description: makes numbers the source of random numbers and starts again from 		first number
+	*/
+	__numbers = numbers;
+	__size = size;
+	__window = numbers;
+	__window_left = 0;
 	return;
 }
 
+void load_random_numbers(char *filename) {
+	/*
+		Function Name: load_random_numbers
+		Arguments:
+			char *filename: path to rfile
+		Returns: void
+		Description: loads random numbers from rfile into __numbers array and initializes 		__size and window
+	*/
+	int *numbers;
+	int size = read_random_numbers(filename, &numbers);
+	use_random_numbers(numbers, size);
+	return;
+}
+
+
+void refill_window() {
+	/*
+		Function Name: refill_window
+		Returns: void
+		Description: makes window cover the whole array again once it is used up, so 		that wrap around is checked once per window instead of once per number
+	*/
+	__window = __numbers;
+	__window_left = __size;
+}
+
+inline int next_random() {
+	/*
+		Function Name: next_random
+		Returns: int - next random number from rfile
+		Description: takes next number from window, refilling it when used up
+	*/
+	if(__window_left == 0) {
+		refill_window();
+	}
+	__window_left--;
+	return *__window++;
+}
+
+void draw_random(int *values, int count) {
+	/*
+		Function Name: draw_random
+		Arguments:
+			int *values: array to be filled
+			int count: number of random numbers to be drawn
+		Returns: void
+		Description: copies next count random numbers into values, same as calling 		next_random count times
+	*/
+	while(count > 0) {
+		if(__window_left == 0) {
+			refill_window();
+		}
+		int n = count < __window_left ? count : __window_left;
+		memcpy(values, __window, n*sizeof(int));
+		__window += n;
+		__window_left -= n;
+		values += n;
+		count -= n;
+	}
+}
 
 int myrandom(int burst) {
 	/*
@@ -45,8 +122,92 @@ int myrandom(int burst) {
 		Returns: int - random burst
 		Description: takes random number from array and generates the burst using burst.
 	*/
-	int num = __numbers[__curr];
-	num = num % burst;
-	__curr = (__curr + 1) % __size;
-	return num;
+	return next_random() % burst;
+}
+
+int draw_cpu_burst(Process *proc) {
+	/*
+		Function Name: draw_cpu_burst
+		Arguments:
+			Process *proc: process for which burst is generated
+		Returns: int - cpu burst in [1, cb], same as myrandom(proc->cb)+1
+		Description: generates cpu burst using precomputed divisor of the process, in 		common random numbers mode takes next burst of process stream instead
+	*/
+	if(proc->cpu_stream != NULL) {
+		return *proc->cpu_stream++;
+	}
+	return fastmod(next_random(), proc->cb_magic, proc->cb) + 1;
+}
+
+int draw_io_burst(Process *proc) {
+	/*
+		Function Name: draw_io_burst
+		Arguments:
+			Process *proc: process for which burst is generated
+		Returns: int - io burst in [1, io], same as myrandom(proc->io)+1
+		Description: generates io burst using precomputed divisor of the process, in 		common random numbers mode takes next burst of process stream instead
+	*/
+	if(proc->io_stream != NULL) {
+		return *proc->io_stream++;
+	}
+	return fastmod(next_random(), proc->io_magic, proc->io) + 1;
+}
+
+uint64_t splitmix64(uint64_t *state) {
+	/*
+		Function Name: splitmix64
+		Arguments:
+			uint64_t *state: state of generator, advanced by the call
+		Returns: uint64_t - next pseudo random number
+		Description: small seeded generator used when rfile is not to be used
+	*/
+	uint64_t z = (*state += UINT64_C(0x9E3779B97F4A7C15));
+	z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+	z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+	return z ^ (z >> 31);
+}
+
+Streams* generate_streams(std::vector<Process*> &processes, bool seeded, uint64_t seed) {
+	/*
+		Function Name: generate_streams
+		Arguments:
+			std::vector<Process*> &processes: processes for which streams are generated
+			bool seeded: use generator seeded by seed instead of rfile
+			uint64_t seed: seed, used only if seeded is true
+		Returns: Streams* - burst streams of all processes
+		Description: pre draws for each process cpu bursts till they cover its total cpu 		time and as many io bursts, which is the most any scheduler uses. Numbers are 		taken from rfile in order of processes, or from a generator seeded by seed and pid 		so that stream of a process does not depend on other processes.
+	*/
+	Streams *streams = new Streams();
+	std::vector<int> raw;
+	for(int i = 0; i < processes.size(); i++) {
+		Process *proc = processes[i];
+		uint64_t state = seed ^ (UINT64_C(0xD1B54A32D192ED03) * (proc->pid + 1));
+		int bursts = 0;
+		long total = 0;
+		streams->offset.push_back(streams->pool.size());
+
+		// cpu bursts, count is known only once they cover total cpu time
+		while(total < proc->tc) {
+			int value = seeded ? (int)(splitmix64(&state) >> 33) : next_random();
+			int burst = fastmod(value, proc->cb_magic, proc->cb) + 1;
+			streams->pool.push_back(burst);
+			total += burst;
+			bursts++;
+		}
+
+		// io bursts, drawn as a batch
+		raw.resize(bursts);
+		if(seeded) {
+			for(int b = 0; b < bursts; b++) {
+				raw[b] = (int)(splitmix64(&state) >> 33);
+			}
+		} else if(bursts != 0) {
+			draw_random(&raw[0], bursts);
+		}
+		for(int b = 0; b < bursts; b++) {
+			streams->pool.push_back(fastmod(raw[b], proc->io_magic, proc->io) + 1);
+		}
+		streams->bursts.push_back(bursts);
+	}
+	return streams;
 }
\ No newline at end of file
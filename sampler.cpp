@@ -0,0 +1,103 @@
+/*
+	Module Name: sampler.cpp
+	Description: samples run queue length, cpu busy fraction and number of blocked 		processes at fixed interval of simulated time into a ring buffer and writes the series 		at the end.
+*/
+#include <stdio.h>
+#include <string.h>
+
+// one sample, describes the interval ending at time
+struct Sample {
+	long long time;
+	int run_queue; // processes in run queue
+	int blocked; // processes blocked for io
+	float cpu_busy; // fraction of the interval cpu was busy
+};
+
+bool sampling = false; // set when sampling is enabled, checked before every hook
+int __interval; // simulated time between samples
+Sample *__samples; // ring buffer, oldest sample is overwritten when full
+int __capacity; // size of ring buffer
+long long __taken; // number of samples taken, __taken % __capacity is next slot
+long long __next_sample; // time of next sample
+long long __last_time; // time till which busy time is accounted
+long long __busy; // busy time in current interval
+
+
+void start_sampling(int interval, int capacity) {
+	/*
+		Function Name: start_sampling
+		Arguments:
+			int interval: simulated time between samples
+			int capacity: number of samples kept, older ones are overwritten
+		Returns: void
+		Description: allocates ring buffer and enables sampling from time zero
+	*/
+	__interval = interval > 0 ? interval : 1;
+	__capacity = capacity > 0 ? capacity : 1;
+	__samples = new Sample[__capacity];
+	__taken = 0;
+	__next_sample = __interval;
+	__last_time = 0;
+	__busy = 0;
+	sampling = true;
+}
+
+void sample_until(long long time, bool cpu_busy, int run_queue, int blocked) {
+	/*
+		Function Name: sample_until
+		Arguments:
+			long long time: current simulation time
+			bool cpu_busy: whether a process has been running since last call
+			int run_queue: processes in run queue since last call
+			int blocked: processes blocked since last call
+		Returns: void
+		Description: called before an event changes the state, takes samples for all 		intervals ending before time with the state that held since last call
+	*/
+	while(__next_sample < time) {
+		if(cpu_busy) {
+			__busy += __next_sample - __last_time;
+		}
+		Sample *sample = &__samples[__taken % __capacity];
+		sample->time = __next_sample;
+		sample->run_queue = run_queue;
+		sample->blocked = blocked;
+		sample->cpu_busy = (float)__busy / __interval;
+		__taken++;
+		__busy = 0;
+		__last_time = __next_sample;
+		__next_sample += __interval;
+	}
+	if(cpu_busy) {
+		__busy += time - __last_time;
+	}
+	__last_time = time;
+}
+
+void write_samples(char *filename) {
+	/*
+		Function Name: write_samples
+		Arguments:
+			char *filename: path of output file
+		Returns: void
+		Description: writes samples oldest first, as raw Sample records if filename ends 		with .bin and as csv otherwise
+	*/
+	FILE *file = fopen(filename, "w");
+	if(file == NULL) {
+		perror(filename);
+		return;
+	}
+	bool binary = strlen(filename) > 4 && strcmp(filename + strlen(filename) - 4, ".bin") == 0;
+	long long first = __taken > __capacity ? __taken - __capacity : 0;
+	if(!binary) {
+		fprintf(file, "time,run_queue,cpu_busy,blocked\n");
+	}
+	for(long long i = first; i < __taken; i++) {
+		Sample *sample = &__samples[i % __capacity];
+		if(binary) {
+			fwrite(sample, sizeof(Sample), 1, file);
+		} else {
+			fprintf(file, "%lld,%d,%.3f,%d\n", sample->time, sample->run_queue, sample->cpu_busy, sample->blocked);
+		}
+	}
+	fclose(file);
+}
@@ -3,7 +3,10 @@
 	Description: Contains definitions of all the classes to be used in the program
 */
 #include <stdio.h>
-#include <list>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include <vector>
 
 #ifndef STATE_H
 #define STATE_H
@@ -13,6 +16,57 @@ enum State {CREATE, READY, RUNNING, BLOCK, PREEMPT};
 
 #endif
 
+#ifndef FASTMOD_H
+#define FASTMOD_H
+
+// remainder by a divisor known in advance using multiplication instead of division, 
+// exact for all 32 bit values (Lemire's fastmod)
+inline uint64_t fastmod_magic(uint32_t divisor) {
+	return UINT64_C(0xFFFFFFFFFFFFFFFF) / divisor + 1;
+}
+
+inline uint32_t fastmod(uint32_t value, uint64_t magic, uint32_t divisor) {
+	return (uint32_t)(((__uint128_t)(magic * value) * divisor) >> 64);
+}
+
+#endif
+
+#ifndef EVENT_H
+#define EVENT_H
+
+class Process;
+
+// for defining an event, every process has one event embedded in it which is reused for 
+// all its transitions as a process never has more than one pending event
+class Event {
+public:
+	long long timestamp;
+	Process *process;
+	State oldstate;
+	State newstate;
+	// links of intrusive event queue
+	Event *prev;
+	Event *next;
+	// set while event is in event queue
+	bool queued;
+
+	// Constructor
+	Event(long long timestamp, Process *process, State oldstate, State newstate) {
+		this->timestamp = timestamp;
+		this->process = process;
+		this->oldstate = oldstate;
+		this->newstate = newstate;
+		prev = NULL;
+		next = NULL;
+		queued = false;
+	}
+
+	// prints an event, used only for debugging, defined after Process
+	void print();
+};
+
+#endif
+
 #ifndef PROCESS_H
 #define PROCESS_H
 
@@ -20,28 +74,44 @@ enum State {CREATE, READY, RUNNING, BLOCK, PREEMPT};
 class Process {
 public:
 	int pid;
-	int at;
+	long long at;
 	int tc;
 	int cb;
 	int io;
 	int prio;
-	int ft;
-	int tt;
-	int it;
-	int cw;
+	// times are 64 bit as a long run passes range of int
+	long long ft;
+	long long tt;
+	long long it;
+	long long cw;
 	State st;
 	
 	// state timestamp to hold timestamp when it was transitioned into its current state
-	int state_ts; 
+	long long state_ts; 
 	// time remaining to complete total cpu time
 	int time_remaining;
 	// current burst remaining time, used for preemptive algorithms
 	int current_burst;
 	// its current priority, used for PRIO scheduling where priority changes
 	int current_prio;
+	// pending RUNNING -> BLOCK/PREEMPT event, kept so that it can be cancelled on preemption
+	Event *pending_event;
+	// precomputed fastmod_magic of cb and io used for generating bursts
+	uint64_t cb_magic;
+	uint64_t io_magic;
+	// next cpu and io burst in common random numbers mode, NULL otherwise
+	int *cpu_stream;
+	int *io_stream;
+	// the only event of the process, see Event
+	Event event;
+	// links of intrusive run queue, a process is in atmost one run queue at a time
+	Process *rq_prev;
+	Process *rq_next;
+	// set while process is in a run queue
+	bool in_run_queue;
 
 	// Constructor
-	Process(int at, int tc, int cb, int io, int pid, int prio) {
+	Process(long long at, int tc, int cb, int io, int pid, int prio) : event(at, this, CREATE, READY) {
 		this -> at = at;
 		this -> tc = tc;
 		this -> cb = cb;
@@ -58,6 +128,33 @@ public:
 		st = CREATE;
 		time_remaining = tc;
 		current_prio = prio;
+		pending_event = NULL;
+		// zero divisor has no magic, such a burst is never drawn by a process that can 
+		// run to completion
+		cb_magic = cb != 0 ? fastmod_magic(cb) : 0;
+		io_magic = io != 0 ? fastmod_magic(io) : 0;
+		cpu_stream = NULL;
+		io_stream = NULL;
+		rq_prev = NULL;
+		rq_next = NULL;
+		in_run_queue = false;
+	}
+
+	Event* next_event(long long timestamp, State oldstate, State newstate) {
+		/*
+			Function Name: next_event
+			Arguments:
+				long long timestamp: time of the transition
+				State oldstate: state process is in
+				State newstate: state process goes to
+			Returns: Event* - embedded event describing the transition, to be put in queue
+			Description: reuses the embedded event for next transition, it must not be 			in the queue
+		*/
+		assert(!event.queued);
+		event.timestamp = timestamp;
+		event.oldstate = oldstate;
+		event.newstate = newstate;
+		return &event;
 	}
 
 	void print_process() {
@@ -66,42 +163,269 @@ public:
 			Returns: void
 			Description: Prints the process and its calculated metrics in the format 			specified
 		*/
-		printf("%04d: %4d %4d %4d %4d %1d | %5d %5d %5d %5d\n", pid, at, tc, cb, io, prio, ft, tt, it, cw);
+		printf("%04d: %4lld %4d %4d %4d %1d | %5lld %5lld %5lld %5lld\n", pid, at, tc, cb, io, prio, ft, tt, it, cw);
 	}
 };
 
+inline void Event::print() {
+	/*
+		Function Name: print
+		Returns: void
+		Description: prints an event, used only for debugging.
+	*/
+	printf("%lld %d %d %d\n", timestamp, process->pid, oldstate, newstate);
+}
+
 
 #endif
 
 
-#ifndef EVENT_H
-#define EVENT_H
+#ifndef PROCESS_QUEUE_H
+#define PROCESS_QUEUE_H
 
-// for defining an event
-class Event {
-public:
-	int timestamp;
-	Process *process;
-	State oldstate;
-	State newstate;
+// intrusive doubly linked list of processes using links embedded in Process, so that 
+// adding and removing never allocates
+class ProcessQueue {
+private:
+	Process *head;
+	Process *tail;
+	int count;
 
+public:
 	// Constructor
-	Event(int timestamp, Process *process, State oldstate, State newstate) {
-		this->timestamp = timestamp;
-		this->process = process;
-		this->oldstate = oldstate;
-		this->newstate = newstate;
+	ProcessQueue() {
+		head = NULL;
+		tail = NULL;
+		count = 0;
+	}
+
+	Process* front() {
+		return head;
+	}
+
+	int size() {
+		return count;
 	}
 
-	void print() {
+	void insert(Process *position, Process *process) {
 		/*
-			Function Name: print
+			Function Name: insert
+			Arguments:
+				Process *position: process in queue before which process is inserted, NULL 				to insert at the end
+				Process *process: process to be inserted, must not be in any run queue
 			Returns: void
-			Description: prints an event, used only for debugging.
+			Description: links process into queue before position
+		*/
+		assert(!process->in_run_queue);
+		process->in_run_queue = true;
+		process->rq_next = position;
+		process->rq_prev = position != NULL ? position->rq_prev : tail;
+		if(process->rq_prev != NULL) {
+			process->rq_prev->rq_next = process;
+		} else {
+			head = process;
+		}
+		if(position != NULL) {
+			position->rq_prev = process;
+		} else {
+			tail = process;
+		}
+		count++;
+	}
+
+	void push_back(Process *process) {
+		insert(NULL, process);
+	}
+
+	void push_front(Process *process) {
+		insert(head, process);
+	}
+
+	Process* pop_front() {
+		/*
+			Function Name: pop_front
+			Returns: Process* - process removed from front, NULL if queue is empty
+			Description: unlinks first process of queue
+		*/
+		Process *process = head;
+		if(process == NULL) {
+			return NULL;
+		}
+		head = process->rq_next;
+		if(head != NULL) {
+			head->rq_prev = NULL;
+		} else {
+			tail = NULL;
+		}
+		process->rq_next = NULL;
+		process->in_run_queue = false;
+		count--;
+		return process;
+	}
+};
+
+#endif
+
+
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+// holds columns of input file, processes are built from it
+class Workload {
+public:
+	int count;
+	int *at;
+	int *tc;
+	int *cb;
+	int *io;
+
+	// Constructor
+	Workload(int count) {
+		this->count = count;
+		at = new int[count];
+		tc = new int[count];
+		cb = new int[count];
+		io = new int[count];
+	}
+
+	// Constructor for columns stored one after another in memory owned by caller
+	Workload(int count, int *columns) {
+		this->count = count;
+		at = columns;
+		tc = columns + count;
+		cb = columns + 2*(long)count;
+		io = columns + 3*(long)count;
+	}
+};
+
+#endif
+
+
+#ifndef STREAMS_H
+#define STREAMS_H
+
+// per process burst streams for common random numbers mode, process i has bursts[i] cpu 
+// bursts starting at pool[offset[i]] followed by as many io bursts. Streams are only read 
+// during simulation so one instance is shared by all runs on same workload.
+class Streams {
+public:
+	std::vector<int> pool;
+	std::vector<long> offset;
+	std::vector<int> bursts;
+};
+
+#endif
+
+
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+// log bucketed histogram of non negative values with fixed memory, values below 128 are 
+// exact and larger values are kept with 64 sub buckets per power of two i.e. within 
+// about 1.5% of their value
+class Histogram {
+public:
+	static const int BUCKETS = 128 + 56*64; // enough for any non negative long long
+	long long counts[BUCKETS];
+	long long total; // number of values recorded
+	long long max; // largest value recorded
+
+	// Constructor
+	Histogram() {
+		memset(counts, 0, sizeof(counts));
+		total = 0;
+		max = 0;
+	}
+
+	static int bucket_index(long long value) {
+		/*
+			Function Name: bucket_index
+			Arguments:
+				long long value: non negative value
+			Returns: int - index of bucket holding value
+			Description: below 128 value is the index, otherwise value is shifted till it 			is in [64, 128) and shift selects group of 64 buckets
 		*/
-		printf("%d %d %d %d\n", timestamp, process->pid, oldstate, newstate);
+		if(value < 128) {
+			return value;
+		}
+		int shift = 63 - __builtin_clzll(value) - 6;
+		return 128 + (shift-1)*64 + ((value >> shift) - 64);
 	}
 
+	static long long bucket_high(int index) {
+		/*
+			Function Name: bucket_high
+			Arguments:
+				int index: index of bucket
+			Returns: long long - largest value falling in bucket
+			Description: inverse of bucket_index
+		*/
+		if(index < 128) {
+			return index;
+		}
+		int shift = (index-128)/64 + 1;
+		unsigned long long sub = (index-128)%64 + 64;
+		// unsigned as high end of last bucket is only just within range of long long
+		return (long long)(((sub+1) << shift) - 1);
+	}
+
+	bool record(long long value) {
+		/*
+			Function Name: record
+			Arguments:
+				long long value: non negative value to be recorded
+			Returns: bool - false if value is negative and was not recorded
+			Description: counts value in its bucket
+		*/
+		if(value < 0) {
+			return false;
+		}
+		counts[bucket_index(value)]++;
+		total++;
+		if(value > max) {
+			max = value;
+		}
+		return true;
+	}
+
+	long long percentile(double p) {
+		/*
+			Function Name: percentile
+			Arguments:
+				double p: percentile in [0, 100]
+			Returns: long long - value below or equal to which p percent of values lie, 0 			if nothing is recorded
+			Description: walks buckets till p percent of values are covered and returns 			largest value of that bucket
+		*/
+		long long target = (long long)(p/100.0*total + 0.999999);
+		if(target < 1) {
+			target = 1;
+		}
+		long long seen = 0;
+		for(int i = 0; i < BUCKETS; i++) {
+			seen += counts[i];
+			if(seen >= target) {
+				return bucket_high(i) < max ? bucket_high(i) : max;
+			}
+		}
+		return max;
+	}
+
+	void merge(Histogram *other) {
+		/*
+			Function Name: merge
+			Arguments:
+				Histogram *other: histogram to be added to this one
+			Returns: void
+			Description: adds counts of other, result is same as if values of both were 			recorded in this one
+		*/
+		for(int i = 0; i < BUCKETS; i++) {
+			counts[i] += other->counts[i];
+		}
+		total += other->total;
+		if(other->max > max) {
+			max = other->max;
+		}
+	}
 };
 
 #endif
@@ -121,6 +445,16 @@ public:
 	virtual Process* get_next_process() {
 		return NULL;
 	}
+
+	// virtual function to be defined in child class
+	virtual int size() {
+		return 0;
+	}
+
+	// virtual function to be defined in preemptive child class
+	virtual bool test_preempt(Process *process, Process *running, long long current_time) {
+		return false;
+	}
 };
 
 #endif
@@ -131,7 +465,7 @@ public:
 // defines a FIFO Scheduler
 class FIFOScheduler: public Scheduler {
 private:
-	std::list<Process*> run_queue; // data structure to maintain run_queue
+	ProcessQueue run_queue; // data structure to maintain run_queue
 
 public:
 	void add_process(Process *process) {
@@ -159,6 +493,14 @@ public:
 		return process;
 	}
 
+	int size() {
+		/*
+			Function Name: size
+			Returns: int - number of processes in run queue
+			Description: returns the number of processes waiting in run queue
+		*/
+		return run_queue.size();
+	}
 };
 
 #endif
@@ -168,7 +510,7 @@ public:
 
 class SJFScheduler: public Scheduler {
 private:
-	std::list<Process*> run_queue; //data strucuture for run queue
+	ProcessQueue run_queue; //data strucuture for run queue
 
 public:
 
@@ -184,9 +526,9 @@ public:
 			run_queue.push_back(process);
 			return;
 		}
-		std::list<Process*>::iterator i = run_queue.begin();
-		while(i != run_queue.end() && process->time_remaining >= (*i)->time_remaining) {
-			i++;
+		Process *i = run_queue.front();
+		while(i != NULL && process->time_remaining >= i->time_remaining) {
+			i = i->rq_next;
 		}
 		run_queue.insert(i, process);
 		return;
@@ -205,6 +547,15 @@ public:
 		run_queue.pop_front();
 		return process;
 	}
+
+	int size() {
+		/*
+			Function Name: size
+			Returns: int - number of processes in run queue
+			Description: returns the number of processes waiting in run queue
+		*/
+		return run_queue.size();
+	}
 };
 
 #endif
@@ -214,7 +565,7 @@ public:
 
 class LCFSScheduler : public Scheduler {
 private:
-	std::list<Process*> run_queue;
+	ProcessQueue run_queue;
 
 public:
 	void add_process(Process *process) {
@@ -241,6 +592,15 @@ public:
 		run_queue.pop_front();
 		return process;
 	}
+
+	int size() {
+		/*
+			Function Name: size
+			Returns: int - number of processes in run queue
+			Description: returns the number of processes waiting in run queue
+		*/
+		return run_queue.size();
+	}
 };
 
 #endif
@@ -252,8 +612,8 @@ class PRIOScheduler : public Scheduler {
 private:
 	// maintains two queue where one is active and other is inactive
 	// queue is switched when no active processes remain in one
-	std::list<Process*> queue1;
-	std::list<Process*> queue2;
+	ProcessQueue queue1;
+	ProcessQueue queue2;
 
 	// flag to indicate which queue is active
 	bool is_queue1_active;
@@ -266,9 +626,9 @@ private:
 			Returns: void
 			Description: Inserts the process in queue 1 in the sorted order of current_prio
 		*/
-		std::list<Process*>::iterator i = queue1.begin();
-		while(i != queue1.end() && (*i)->current_prio >= process->current_prio) {
-			i++;
+		Process *i = queue1.front();
+		while(i != NULL && i->current_prio >= process->current_prio) {
+			i = i->rq_next;
 		}
 		queue1.insert(i, process);
 	}
@@ -281,9 +641,9 @@ private:
 			Returns: void
 			Description: Inserts the process in queue 2 in the sorted order of current_prio
 		*/
-		std::list<Process*>::iterator i = queue2.begin();
-		while(i != queue2.end() && (*i)->current_prio >= process->current_prio) {
-			i++;
+		Process *i = queue2.front();
+		while(i != NULL && i->current_prio >= process->current_prio) {
+			i = i->rq_next;
 		}
 		queue2.insert(i, process);
 	}
@@ -348,6 +708,59 @@ public:
 			return process;
 		}
 	}
+
+	int size() {
+		/*
+			Function Name: size
+			Returns: int - number of processes in run queue
+			Description: returns the number of processes waiting in both queues
+		*/
+		return queue1.size() + queue2.size();
+	}
 };
 
-#endif
\ No newline at end of file
+#endif
+#ifndef SRTF_SCHEDULER_H
+#define SRTF_SCHEDULER_H
+
+// preemptive version of SJF i.e. shortest remaining time first
+class SRTFScheduler: public SJFScheduler {
+public:
+	bool test_preempt(Process *process, Process *running, long long current_time) {
+		/*
+			Function Name: test_preempt
+			Arguments:
+				Process *process: process which just became ready
+				Process *running: process currently running
+				long long current_time: current simulation time
+			Returns: bool - true if running process should be preempted
+			Description: preempts if ready process has less time remaining than the 			running one, time_remaining of running process is already reduced by its 			whole burst so unused part of the burst is added back
+		*/
+		long long running_remaining = running->time_remaining + (running->pending_event->timestamp - current_time);
+		return process->time_remaining < running_remaining;
+	}
+};
+
+#endif
+
+#ifndef PREPRIO_SCHEDULER_H
+#define PREPRIO_SCHEDULER_H
+
+// preemptive version of PRIO scheduler
+class PreemptivePRIOScheduler: public PRIOScheduler {
+public:
+	bool test_preempt(Process *process, Process *running, long long current_time) {
+		/*
+			Function Name: test_preempt
+			Arguments:
+				Process *process: process which just became ready
+				Process *running: process currently running
+				long long current_time: current simulation time
+			Returns: bool - true if running process should be preempted
+			Description: preempts if ready process has higher priority than the running 			one, current_prio of running process is already decremented when it started 			running so one is added back
+		*/
+		return process->current_prio > running->current_prio + 1;
+	}
+};
+
+#endif
@@ -0,0 +1,286 @@
+/*
+	Module Name: server.cpp
+	Description: runs sched as a long running service, input files and rfiles are loaded 		only once and kept resident while simulation requests are served by a pool of worker 		processes.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <list>
+#include <string>
+#include <vector>
+#include "scheduler.h"
+
+/************************** Imported from random.cpp **************************/
+extern int read_random_numbers(char *filename, int **numbers);
+extern void use_random_numbers(int *numbers, int size);
+extern Streams* generate_streams(std::vector<Process*> &processes, bool seeded, uint64_t seed);
+
+/************************** Imported from process.cpp **************************/
+extern Workload* read_workload(char *filename);
+extern std::vector<Process*> processes;
+extern void build_processes(Workload *workload);
+extern void attach_streams(Streams *streams);
+extern void reset_processes();
+
+/************************** Imported from simulation.cpp **************************/
+extern void simulate(char sched, int num, bool verbose);
+
+// resident inputs, index in vector is the id used in requests
+std::vector<Workload*> __workloads;
+std::vector<int*> __rnumbers;
+std::vector<int> __rsizes;
+// common random numbers streams of input i with rfile j at i*__rnumbers.size()+j, empty 
+// if mode is off
+std::vector<Streams*> __streams;
+
+// a request in progress, its output is read from fd in the order of requests
+struct Job {
+	pid_t pid; // worker running the request, -1 if output was produced by server itself
+	int fd; // read end of pipe carrying the output, -1 if output is in text
+	std::string text; // output produced by server itself
+};
+
+
+void write_all(int fd, const char *buffer, int length) {
+	/*
+		Function Name: write_all
+		Arguments:
+			int fd: file descriptor to write to
+			const char *buffer: data to be written
+			int length: number of bytes in buffer
+		Returns: void
+		Description: writes whole buffer, output is dropped if client has gone away
+	*/
+	while(length > 0) {
+		int written = write(fd, buffer, length);
+		if(written < 0) {
+			if(errno == EINTR) continue;
+			return;
+		}
+		buffer += written;
+		length -= written;
+	}
+}
+
+Job start_request(std::string &line) {
+	/*
+		Function Name: start_request
+		Arguments:
+			std::string &line: request line "<sched> <input-id> <rfile-id> [v]"
+		Returns: Job - job whose output answers the request
+		Description: validates the request and forks a worker to run the simulation on 		the resident inputs, output of the worker is the same as that of sched followed by 		a line "END". Invalid request, or one for which no worker could be started, is 		answered by "ERROR <request>" line.
+	*/
+	Job job;
+	int pipefd[2];
+	char spec[16];
+	char flag = 0;
+	int input_id = -1, rfile_id = -1, num = -1;
+	job.pid = -1;
+	job.fd = -1;
+	job.text = "ERROR " + line + "\n";
+
+	int fields = sscanf(line.c_str(), "%15s %d %d %c", spec, &input_id, &rfile_id, &flag);
+	if(fields >= 1 && (spec[0] == 'R' || spec[0] == 'P' || spec[0] == 'E')) {
+		num = atoi(spec+1);
+	}
+	// quantum must be positive for R, P and E, otherwise worker would never finish
+	if(fields < 3 || strchr("FLSRPTE", spec[0]) == NULL || (flag != 0 && flag != 'v') ||
+		((spec[0] == 'R' || spec[0] == 'P' || spec[0] == 'E') && num < 1) ||
+		input_id < 0 || input_id >= (int)__workloads.size() ||
+		rfile_id < 0 || rfile_id >= (int)__rnumbers.size()) {
+		return job;
+	}
+	if(pipe(pipefd) < 0) {
+		perror("pipe");
+		return job;
+	}
+
+	fflush(stdout);
+	job.pid = fork();
+	if(job.pid == 0) {
+		// worker gets a copy of resident inputs, so it can change them freely
+		close(pipefd[0]);
+		dup2(pipefd[1], 1);
+		close(pipefd[1]);
+		use_random_numbers(__rnumbers[rfile_id], __rsizes[rfile_id]);
+		build_processes(__workloads[input_id]);
+		if(__streams.size() != 0) {
+			attach_streams(__streams[input_id*__rnumbers.size() + rfile_id]);
+		}
+		simulate(spec[0], num, flag == 'v');
+		printf("END\n");
+		fflush(stdout);
+		_exit(0);
+	}
+	close(pipefd[1]);
+	if(job.pid < 0) {
+		perror("fork");
+		close(pipefd[0]);
+		return job;
+	}
+	job.fd = pipefd[0];
+	return job;
+}
+
+void serve_client(int in_fd, int out_fd, int workers) {
+	/*
+		Function Name: serve_client
+		Arguments:
+			int in_fd: file descriptor requests are read from
+			int out_fd: file descriptor responses are written to
+			int workers: maximum number of requests simulated at once
+		Returns: void
+		Description: reads request lines till end of input, runs upto workers requests in 		parallel and streams back their output in the order of requests
+	*/
+	std::list<Job> jobs;
+	std::string pending; // input read but not yet started as request
+	bool input_open = true;
+	char buffer[65536];
+
+	while(input_open || pending.size() != 0 || jobs.size() != 0) {
+		// start as many complete requests as workers allow
+		size_t eol;
+		while((int)jobs.size() < workers && (eol = pending.find('\n')) != std::string::npos) {
+			std::string line = pending.substr(0, eol);
+			pending.erase(0, eol+1);
+			if(line.find_first_not_of(" \t\r") != std::string::npos) {
+				jobs.push_back(start_request(line));
+			}
+		}
+		// output produced by server itself is ready at once
+		while(jobs.size() != 0 && jobs.front().fd < 0) {
+			write_all(out_fd, jobs.front().text.c_str(), jobs.front().text.size());
+			jobs.pop_front();
+		}
+		// last request may not end with newline
+		if(!input_open && pending.size() != 0 && pending.find('\n') == std::string::npos) {
+			pending += '\n';
+			continue;
+		}
+
+		// wait for more input if a worker is free and for output of oldest request
+		struct pollfd fds[2];
+		int nfds = 0, in_index = -1, job_index = -1;
+		if(input_open && (int)jobs.size() < workers) {
+			fds[nfds].fd = in_fd;
+			fds[nfds].events = POLLIN;
+			in_index = nfds++;
+		}
+		if(jobs.size() != 0) {
+			fds[nfds].fd = jobs.front().fd;
+			fds[nfds].events = POLLIN;
+			job_index = nfds++;
+		}
+		if(nfds == 0) {
+			continue;
+		}
+		if(poll(fds, nfds, -1) < 0) {
+			continue;
+		}
+
+		if(job_index >= 0 && fds[job_index].revents) {
+			int length = read(jobs.front().fd, buffer, sizeof(buffer));
+			if(length > 0) {
+				write_all(out_fd, buffer, length);
+			} else if(length == 0 || errno != EINTR) {
+				close(jobs.front().fd);
+				if(jobs.front().pid > 0) {
+					waitpid(jobs.front().pid, NULL, 0);
+				}
+				jobs.pop_front();
+			}
+		}
+		if(in_index >= 0 && fds[in_index].revents) {
+			int length = read(in_fd, buffer, sizeof(buffer));
+			if(length > 0) {
+				pending.append(buffer, length);
+			} else if(length == 0 || errno != EINTR) {
+				input_open = false;
+			}
+		}
+	}
+}
+
+void serve(std::vector<char*> &input_files, std::vector<char*> &rfiles, char *socket_path, int workers, bool crn, bool seeded, uint64_t seed) {
+	/*
+		Function Name: serve
+		Arguments:
+			std::vector<char*> &input_files: input files, request refers to them by index
+			std::vector<char*> &rfiles: rfiles, request refers to them by index
+			char *socket_path: path of unix socket to listen on, NULL to use stdin/stdout
+			int workers: maximum number of requests of a client simulated at once
+			bool crn: common random numbers mode
+			bool seeded, uint64_t seed: as for generate_streams
+		Returns: void
+		Description: loads all inputs once and serves requests, in common random numbers 		mode streams of every input and rfile pair are also generated once and shared 		read only by all workers, with stdin it returns at 		end of input otherwise it accepts clients on socket forever and serves each in 		its own process
+	*/
+	for(int i = 0; i < input_files.size(); i++) {
+		__workloads.push_back(read_workload(input_files[i]));
+	}
+	for(int i = 0; i < rfiles.size(); i++) {
+		int *numbers;
+		int size = read_random_numbers(rfiles[i], &numbers);
+		__rnumbers.push_back(numbers);
+		__rsizes.push_back(size);
+	}
+	for(int i = 0; crn && i < __workloads.size(); i++) {
+		for(int j = 0; j < __rnumbers.size(); j++) {
+			use_random_numbers(__rnumbers[j], __rsizes[j]);
+			build_processes(__workloads[i]);
+			__streams.push_back(generate_streams(processes, seeded, seed));
+			reset_processes();
+		}
+	}
+	if(workers < 1) {
+		workers = 1;
+	}
+
+	// a client going away should not kill the server
+	signal(SIGPIPE, SIG_IGN);
+
+	if(socket_path == NULL) {
+		serve_client(0, 1, workers);
+		return;
+	}
+
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, socket_path, sizeof(address.sun_path)-1);
+	int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	unlink(socket_path);
+	if(listen_fd < 0 || bind(listen_fd, (struct sockaddr*)&address, sizeof(address)) < 0 || listen(listen_fd, 16) < 0) {
+		perror(socket_path);
+		return;
+	}
+	while(true) {
+		int client_fd = accept(listen_fd, NULL, NULL);
+		// reap clients that have gone away
+		while(waitpid(-1, NULL, WNOHANG) > 0);
+		if(client_fd < 0) {
+			continue;
+		}
+		// each client is served by its own process so that an idle client does not 
+		// hold up others
+		fflush(stdout);
+		pid_t pid = fork();
+		if(pid == 0) {
+			close(listen_fd);
+			serve_client(client_fd, client_fd, workers);
+			close(client_fd);
+			_exit(0);
+		}
+		if(pid < 0) {
+			perror("fork");
+		}
+		close(client_fd);
+	}
+}
@@ -1,28 +1,44 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <limits.h>
 #include <vector>
 #include "scheduler.h"
 
 /************************** Imported from des.cpp **************************/
 extern Event* get_event();
 extern void put_event(Event *event, bool pushback);
-extern int get_next_event_time();
+extern long long get_next_event_time();
+extern void cancel_event(Event *event);
 
 /************************** Imported from random.cpp **************************/
-extern int myrandom(int burst);
+extern int draw_cpu_burst(Process *proc);
+extern int draw_io_burst(Process *proc);
 
 /************************** Imported from process.cpp **************************/
 extern std::vector<Process*> processes;
-extern int get_total_time();
+extern long long get_total_time();
 extern double get_cpu_utilization();
 extern double get_avg_turnaround_time();
 extern double get_avg_cpu_wait_time();
 extern double get_throughput();
-extern bool check_blocked();
+extern void record_finished(Process *proc);
+extern bool streaming;
+extern bool quiet;
+extern void stream_arrivals(long long time);
+extern void finish_streamed(Process *proc);
 
+/************************** Imported from sampler.cpp **************************/
+extern bool sampling;
+extern void sample_until(long long time, bool cpu_busy, int run_queue, int blocked);
 
 
-void change_state(Process *proc, State state, int timestamp);
+
+// when set, called before every event and simulation is abandoned if it returns true
+bool (*abort_check)(long long current_time) = NULL;
+bool aborted = false; // set when simulation was abandoned
+
+void change_state(Process *proc, State state, long long timestamp);
+void preempt_process(Process *proc, long long timestamp);
 
 // for printing state if verbose
 const char *s[] = {"CREATE", "READY", "RUNNING", "BLOCK", "PREEMPT"};
@@ -40,8 +56,8 @@ void simulate(char sched, int num, bool verbose) {
 	Event *event = NULL; // for holding current event
 	Process *current_running_process = NULL; // holds current_running_process
 	Process *proc = NULL; // holds process in current event
-	int current_time; // timestamp of current event
-	int prev_state_time; // holds time process spent in previous state
+	long long current_time; // timestamp of current event
+	long long prev_state_time; // holds time process spent in previous state
 	Scheduler *scheduler = NULL; // refers to scheduler
 	bool call_scheduler = false; // flag determining whether to call scheduler
 	double tot_io_time = 0.0; // calculates time anyone process is in io
@@ -49,6 +65,10 @@ void simulate(char sched, int num, bool verbose) {
 	double prev_io_st_time = 0.0; // time is_io flag was set
 	int io_burst, cpu_burst; // holds burst for cpu and io
 	bool preempt = false; // flag to determine whether to preempt or block
+	bool use_quantum = false; // flag to indicate bursts are tracked in current_burst
+	int quantum = num; // time quantum, unlimited for SRTF
+	int blocked = 0; // number of processes blocked for io
+	bool finished = false; // flag to indicate process of current event finished
 
 	// initialize scheduler as per sched argument
 	if(sched == 'F' || sched == 'R') {
@@ -59,20 +79,45 @@ void simulate(char sched, int num, bool verbose) {
 		scheduler = new LCFSScheduler();
 	} else if(sched == 'P') {
 		scheduler = new PRIOScheduler();
+	} else if(sched == 'T') {
+		scheduler = new SRTFScheduler();
+		quantum = INT_MAX;
+	} else if(sched == 'E') {
+		scheduler = new PreemptivePRIOScheduler();
 	} else {
 		return;
 	}
+	use_quantum = (sched == 'R' || sched == 'P' || sched == 'T' || sched == 'E');
+	aborted = false;
 
 
 	// run while event queue is empty
-	while(event = get_event()) {
+	while(true) {
+		// bring in processes arriving till next event when reading them as they come
+		if(streaming) {
+			stream_arrivals(get_next_event_time());
+		}
+		event = get_event();
+		if(event == NULL) {
+			break;
+		}
+
 		// get details of event and process
 		State transition = event->newstate;
 		State prev_state = event->oldstate;
 		current_time = event->timestamp;
+		if(abort_check != NULL && abort_check(current_time)) {
+			aborted = true;
+			return;
+		}
 		proc = event->process;
 		prev_state_time = current_time - proc->state_ts;
 
+		// sample state that held till now
+		if(sampling) {
+			sample_until(current_time, current_running_process != NULL, scheduler->size(), blocked);
+		}
+
 		switch(transition) {
 			case READY:
 			{
@@ -81,7 +126,8 @@ void simulate(char sched, int num, bool verbose) {
 				// set is io to false if no more process is blocked for io
 				// add the time to tot_io_time
 				if(prev_state == BLOCK){
-					is_io = check_blocked();
+					blocked--;
+					is_io = (blocked != 0);
 					if(!is_io) {
 						tot_io_time += (double)current_time - prev_io_st_time;
 					}
@@ -90,6 +136,14 @@ void simulate(char sched, int num, bool verbose) {
 				// add process to run queue
 				scheduler->add_process(proc);
 				call_scheduler = true;
+
+				// preempt running process if scheduler says so, only possible once its 
+				// burst is decided and it is not ending at current time anyway
+				if(current_running_process != NULL && current_running_process->pending_event != NULL &&
+					current_running_process->pending_event->timestamp > current_time &&
+					scheduler->test_preempt(proc, current_running_process, current_time)) {
+					preempt_process(current_running_process, current_time);
+				}
 				break;
 			}
 			case RUNNING:
@@ -100,32 +154,32 @@ void simulate(char sched, int num, bool verbose) {
 				}
 
 				// calculates current cpu burst as per scheduler
-				if(sched == 'R' || sched == 'P') {
+				if(use_quantum) {
 					if(proc->current_burst == 0) {
-						cpu_burst = myrandom(proc->cb)+1;
+						cpu_burst = draw_cpu_burst(proc);
 						proc->current_burst = cpu_burst;
 						preempt = true;
-						if(num >= cpu_burst) {
+						if(quantum >= cpu_burst) {
 							preempt = false;
 						} else {
-							cpu_burst = num;
+							cpu_burst = quantum;
 						}
 					} else {
-						if(proc->current_burst <= num) {
+						if(proc->current_burst <= quantum) {
 							cpu_burst = proc->current_burst;
 						} else {
-							cpu_burst = num;
+							cpu_burst = quantum;
 							preempt = true;
 						}
 					}
 
 					// if scheduler is PRIO then decrease current priority by 1
-					if(sched == 'P') {
+					if(sched == 'P' || sched == 'E') {
 						proc->current_prio -= 1; 
 					}
 					proc->current_burst -= cpu_burst;
 				} else {
-					cpu_burst = myrandom(proc->cb)+1;
+					cpu_burst = draw_cpu_burst(proc);
 				}
 				
 				if(proc->time_remaining < cpu_burst) {
@@ -141,24 +195,28 @@ void simulate(char sched, int num, bool verbose) {
 
 				// put an event for preemption or blocking
 				if(preempt) {
-					put_event(new Event(current_time+cpu_burst, proc, RUNNING, PREEMPT), false);
+					proc->pending_event = proc->next_event(current_time+cpu_burst, RUNNING, PREEMPT);
 					preempt = false;
 				} else {
-					put_event(new Event(current_time+cpu_burst, proc, RUNNING, BLOCK), false);
+					proc->pending_event = proc->next_event(current_time+cpu_burst, RUNNING, BLOCK);
 				}
+				put_event(proc->pending_event, false);
 				break;
 			}
 			case BLOCK:
 			{
 				// change current_prio to original one if scheduler is PRIO
-				if(sched == 'P') {
+				if(sched == 'P' || sched == 'E') {
 					proc->current_prio = proc->prio;
 				}
+				proc->pending_event = NULL;
 				current_running_process = NULL; // no process is running now
 				call_scheduler = true;
 
 				// no need to put event for READY or calculate the burst if process is complete
 				if(proc->time_remaining == 0) {
+					record_finished(proc);
+					finished = true;
 					break;
 				}
 
@@ -167,18 +225,22 @@ void simulate(char sched, int num, bool verbose) {
 					is_io = true;
 					prev_io_st_time = current_time;
 				}
-				io_burst = myrandom(proc->io)+1;
+				io_burst = draw_io_burst(proc);
 				proc->it += io_burst;
 				change_state(proc, BLOCK, current_time);
-				put_event(new Event(current_time+io_burst, proc, BLOCK, READY), false);
+				blocked++;
+				put_event(proc->next_event(current_time+io_burst, BLOCK, READY), false);
 				break;
 			}
 			case PREEMPT:
 			{
+				proc->pending_event = NULL;
 				current_running_process = NULL; // no process is running now
 				call_scheduler = true;
 				// no need to preempt if process is complete
 				if(proc->time_remaining == 0) {
+					record_finished(proc);
+					finished = true;
 					break;
 				}
 				scheduler->add_process(proc);
@@ -191,16 +253,22 @@ void simulate(char sched, int num, bool verbose) {
 		/************* Verbose Print ***************/
 		if(verbose) {
 			if(transition == BLOCK) {
-				printf("%d %d %d: %s -> %s ib=%d rem=%d\n", current_time, proc->pid, prev_state_time, s[prev_state], s[transition], io_burst, proc->time_remaining);
+				printf("%lld %d %lld: %s -> %s ib=%d rem=%d\n", current_time, proc->pid, prev_state_time, s[prev_state], s[transition], io_burst, proc->time_remaining);
 			} else if(transition == RUNNING) {
-				printf("%d %d %d: %s -> %s cb=%d rem=%d, current_burst=%d, prio=%d\n", current_time, proc->pid, prev_state_time, s[prev_state], s[transition], cpu_burst, proc->time_remaining, proc->current_burst, proc->current_prio);
+				printf("%lld %d %lld: %s -> %s cb=%d rem=%d, current_burst=%d, prio=%d\n", current_time, proc->pid, prev_state_time, s[prev_state], s[transition], cpu_burst, proc->time_remaining, proc->current_burst, proc->current_prio);
 			} else {
-				printf("%d %d %d: %s -> %s\n", current_time, proc->pid, prev_state_time, s[prev_state], s[transition]);
+				printf("%lld %d %lld: %s -> %s\n", current_time, proc->pid, prev_state_time, s[prev_state], s[transition]);
 			}
 		}
 		/************* Verbose Print End ***************/
 
-		delete event;
+		// finished process is not kept when streaming
+		if(finished && streaming) {
+			finish_streamed(proc);
+		}
+		finished = false;
+
+		// event belongs to the process and may already be reused for its next transition
 		event = NULL;
 
 		// Call scheduler
@@ -217,7 +285,7 @@ void simulate(char sched, int num, bool verbose) {
 			} else {
 				continue;
 			}
-			put_event(new Event(current_time, current_running_process, current_running_process->st, RUNNING), false);
+			put_event(current_running_process->next_event(current_time, current_running_process->st, RUNNING), false);
 		}
 	}
 
@@ -238,14 +306,18 @@ void simulate(char sched, int num, bool verbose) {
 		printf("RR %d\n", num);
 	} else if(sched == 'P') {
 		printf("PRIO %d\n", num);
+	} else if(sched == 'T') {
+		printf("SRTF\n");
+	} else if(sched == 'E') {
+		printf("PREPRIO %d\n", num);
 	}
 
 
 
-	for(int i = 0; i < processes.size(); i++) {
+	for(int i = 0; !quiet && i < processes.size(); i++) {
 		processes.at(i)->print_process();
 	}
-	printf("SUM: %d %.2lf %.2lf %.2lf %.2lf %.3lf\n",
+	printf("SUM: %lld %.2lf %.2lf %.2lf %.2lf %.3lf\n",
 		get_total_time(),
 		get_cpu_utilization(),
 		(tot_io_time/(double)get_total_time())*100.00,
@@ -257,17 +329,40 @@ void simulate(char sched, int num, bool verbose) {
 }
 
 
-void change_state(Process *proc, State state, int timestamp) {
+void change_state(Process *proc, State state, long long timestamp) {
 	/*
 		Function Name: change_state
 		Arguments:
 			Process *proc: process of which state is to be changed
 			State state: state to be assigned to proc
-			int timestamp: time at which state is changed
+			long long timestamp: time at which state is changed
 		Returns: void
 		Description: Changes the state of the process as specified
 	*/
 	proc->st = state;
 	proc->state_ts = timestamp;
 	return;
+}
+
+void preempt_process(Process *proc, long long timestamp) {
+	/*
+		Function Name: preempt_process
+		Arguments:
+			Process *proc: running process to be preempted
+			long long timestamp: time at which process is preempted
+		Returns: void
+		Description: Cancels pending event of the running process, gives back the unused 		part of its burst and puts a PREEMPT event at timestamp
+	*/
+	int unused = proc->pending_event->timestamp - timestamp;
+	cancel_event(proc->pending_event);
+	proc->pending_event = NULL;
+
+	// burst was accounted for at the time process started running, so add back what 
+	// was not used
+	proc->time_remaining += unused;
+	proc->current_burst += unused;
+	proc->ft = 0;
+	proc->tt = 0;
+	put_event(proc->next_event(timestamp, RUNNING, PREEMPT), false);
+	return;
 }
\ No newline at end of file